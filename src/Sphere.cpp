@@ -18,12 +18,19 @@
 #ifdef __APPLE__
 #include <OpenGL/gl.h>
 #else
+#define GL_GLEXT_PROTOTYPES     // buffer and vertex array entry points from the GL library, no loader
 #include <GL/gl.h>
 #endif
 
+// GPU buffers need GL 3.0 headers, other platforms always draw from client arrays
+#if defined(GL_VERSION_3_0) && !defined(__APPLE__)
+#define SPHERE_USE_BUFFERS
+#endif
+
 #include <iostream>
 #include <iomanip>
 #include <cmath>
+#include <cstdlib>
 #include "Sphere.h"
 
 
@@ -37,7 +44,8 @@ const int MIN_STACK_COUNT  = 2;
 ///////////////////////////////////////////////////////////////////////////////
 // ctor
 ///////////////////////////////////////////////////////////////////////////////
-Sphere::Sphere(float radius, int sectors, int stacks, bool smooth, int up) : interleavedStride(32)
+Sphere::Sphere(float radius, int sectors, int stacks, bool smooth, int up)
+    : buildCount(0), interleavedStride(32), vbo(0), ibo(0), lineIbo(0), vao(0), lineVao(0)
 {
     set(radius, sectors, stacks, smooth, up);
 }
@@ -66,6 +74,7 @@ void Sphere::set(float radius, int sectors, int stacks, bool smooth, int up)
         buildVerticesSmooth();
     else
         buildVerticesFlat();
+    updateBuffers();
 }
 
 void Sphere::setRadius(float radius)
@@ -96,6 +105,7 @@ void Sphere::setSmooth(bool smooth)
         buildVerticesSmooth();
     else
         buildVerticesFlat();
+    updateBuffers();
 }
 
 void Sphere::setUpAxis(int up)
@@ -105,6 +115,7 @@ void Sphere::setUpAxis(int up)
 
     changeUpAxis(this->upAxis, up);
     this->upAxis = up;
+    updateBuffers();
 }
 
 
@@ -137,6 +148,7 @@ void Sphere::reverseNormals()
         indices[i]   = indices[i+2];
         indices[i+2] = tmp;
     }
+    updateBuffers();
 }
 
 
@@ -161,12 +173,108 @@ void Sphere::printSelf() const
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// upload the interleaved vertices and indices into GPU buffers, and record the
+// array setup of draw() and drawLines() in vertex array objects
+// OpenGL RC must be set before calling it
+///////////////////////////////////////////////////////////////////////////////
+bool Sphere::createBuffers()
+{
+#ifdef SPHERE_USE_BUFFERS
+    // the headers may be newer than the context
+    const char* version = (const char*)glGetString(GL_VERSION);
+    if(!version || atoi(version) < 3)
+        return false;
+
+    if(!vao)
+    {
+        glGenBuffers(1, &vbo);
+        glGenBuffers(1, &ibo);
+        glGenBuffers(1, &lineIbo);
+        glGenVertexArrays(1, &vao);
+        glGenVertexArrays(1, &lineVao);
+
+        // the client array state and the element buffer belong to the VAO
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glVertexPointer(3, GL_FLOAT, interleavedStride, (void*)0);
+        glNormalPointer(GL_FLOAT, interleavedStride, (void*)(3 * sizeof(float)));
+        glTexCoordPointer(2, GL_FLOAT, interleavedStride, (void*)(6 * sizeof(float)));
+
+        glBindVertexArray(lineVao);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lineIbo);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glVertexPointer(3, GL_FLOAT, interleavedStride, (void*)0);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    updateBuffers();
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Sphere::releaseBuffers()
+{
+#ifdef SPHERE_USE_BUFFERS
+    if(!vao)
+        return;
+    glDeleteVertexArrays(1, &vao);
+    glDeleteVertexArrays(1, &lineVao);
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &ibo);
+    glDeleteBuffers(1, &lineIbo);
+    vbo = ibo = lineIbo = vao = lineVao = 0;
+#endif
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// copy the arrays into the buffers after they changed, if the buffers exist
+///////////////////////////////////////////////////////////////////////////////
+void Sphere::updateBuffers()
+{
+#ifdef SPHERE_USE_BUFFERS
+    if(!vao)
+        return;
+
+    // element buffers are bound through their VAO so the current one is not changed
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, getInterleavedVertexSize(), interleavedVertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(vao);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, getIndexSize(), indices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(lineVao);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, getLineIndexSize(), lineIndices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+#endif
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // draw a sphere in VertexArray mode
 // OpenGL RC must be set before calling it
 ///////////////////////////////////////////////////////////////////////////////
 void Sphere::draw() const
 {
+#ifdef SPHERE_USE_BUFFERS
+    if(vao)
+    {
+        glBindVertexArray(vao);
+        glDrawElements(GL_TRIANGLES, (unsigned int)indices.size(), GL_UNSIGNED_INT, (void*)0);
+        glBindVertexArray(0);
+        return;
+    }
+#endif
+
     // interleaved array
     glEnableClientState(GL_VERTEX_ARRAY);
     glEnableClientState(GL_NORMAL_ARRAY);
@@ -197,12 +305,21 @@ void Sphere::drawLines(const float lineColor[4]) const
     // draw lines with VA
     glDisable(GL_LIGHTING);
     glDisable(GL_TEXTURE_2D);
-    glEnableClientState(GL_VERTEX_ARRAY);
-    glVertexPointer(3, GL_FLOAT, 0, vertices.data());
-
-    glDrawElements(GL_LINES, (unsigned int)lineIndices.size(), GL_UNSIGNED_INT, lineIndices.data());
-
-    glDisableClientState(GL_VERTEX_ARRAY);
+#ifdef SPHERE_USE_BUFFERS
+    if(lineVao)
+    {
+        glBindVertexArray(lineVao);
+        glDrawElements(GL_LINES, (unsigned int)lineIndices.size(), GL_UNSIGNED_INT, (void*)0);
+        glBindVertexArray(0);
+    }
+    else
+#endif
+    {
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glVertexPointer(3, GL_FLOAT, 0, vertices.data());
+        glDrawElements(GL_LINES, (unsigned int)lineIndices.size(), GL_UNSIGNED_INT, lineIndices.data());
+        glDisableClientState(GL_VERTEX_ARRAY);
+    }
     glEnable(GL_LIGHTING);
     glEnable(GL_TEXTURE_2D);
 }
@@ -276,6 +393,7 @@ void Sphere::clearArrays()
 ///////////////////////////////////////////////////////////////////////////////
 void Sphere::buildVerticesSmooth()
 {
+    ++buildCount;
     const float PI = acos(-1.0f);
 
     // clear memory of prev arrays
@@ -370,6 +488,7 @@ void Sphere::buildVerticesSmooth()
 ///////////////////////////////////////////////////////////////////////////////
 void Sphere::buildVerticesFlat()
 {
+    ++buildCount;
     const float PI = acos(-1.0f);
 
     // tmp vertex definition (x,y,z,s,t)
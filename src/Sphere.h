@@ -21,13 +21,14 @@ class Sphere
 public:
     // ctor/dtor
     Sphere(float radius=1.0f, int sectorCount=36, int stackCount=18, bool smooth=true, int up=3);
-    ~Sphere() {}
+    ~Sphere() {}                            // GL buffers are released by releaseBuffers(), the context may be gone here
 
     // getters/setters
     float getRadius() const                 { return radius; }
     int getSectorCount() const              { return sectorCount; }
     int getStackCount() const               { return stackCount; }
     int getUpAxis() const                   { return upAxis; }
+    unsigned int getBuildCount() const      { return buildCount; }  // # of times the vertices were generated
     void set(float radius, int sectorCount, int stackCount, bool smooth=true, int up=3);
     void setRadius(float radius);
     void setSectorCount(int sectorCount);
@@ -60,7 +61,14 @@ public:
     int getInterleavedStride() const                { return interleavedStride; }   // should be 32 bytes
     const float* getInterleavedVertices() const     { return interleavedVertices.data(); }
 
-    // draw in VertexArray mode
+    // GPU buffers, the OpenGL RC must be set. Without them (or without GL 3.0) draws use client vertex arrays
+    bool createBuffers();                               // upload to VBO/IBO/VAO once, kept in sync by the setters
+    void releaseBuffers();
+    bool hasBuffers() const                 { return vao != 0; }
+    unsigned int getVertexBuffer() const    { return vbo; }     // interleaved V/N/T, 0 without buffers
+    unsigned int getIndexBuffer() const     { return ibo; }
+
+    // draw in VertexArray mode, from the buffers if they were created
     void draw() const;                                  // draw surface
     void drawLines(const float lineColor[4]) const;     // draw lines only
     void drawWithLines(const float lineColor[4]) const; // draw surface and lines
@@ -77,6 +85,7 @@ private:
     void buildInterleavedVertices();
     void changeUpAxis(int from, int to);
     void clearArrays();
+    void updateBuffers();
     void addVertex(float x, float y, float z);
     void addNormal(float x, float y, float z);
     void addTexCoord(float s, float t);
@@ -91,6 +100,7 @@ private:
     int stackCount;                         // latitude, # of stacks
     bool smooth;
     int upAxis;                             // +X=1, +Y=2, +z=3 (default)
+    unsigned int buildCount;
     std::vector<float> vertices;
     std::vector<float> normals;
     std::vector<float> texCoords;
@@ -101,6 +111,13 @@ private:
     std::vector<float> interleavedVertices;
     int interleavedStride;                  // # of bytes to hop to the next vertex (should be 32 bytes)
 
+    // GPU buffers, 0 if not created
+    unsigned int vbo;                       // interleaved vertices
+    unsigned int ibo;                       // triangle indices
+    unsigned int lineIbo;                   // line indices
+    unsigned int vao;                       // surface arrays
+    unsigned int lineVao;                   // vertex array and line indices
+
 };
 
 #endif
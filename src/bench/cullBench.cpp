@@ -0,0 +1,112 @@
+///////////////////////////////////////////////////////////////////////////////
+// cullBench.cpp
+// =============
+// Time of the frustum culling pass over body arrays of growing size, checked
+// against one sphere at a time, next to the angle test it replaced.
+//
+// usage: cullBench [count ...]
+// Bodies are spread at random through a solar system sized cube, with radii
+// from asteroids to gas giants.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "../render/frustum.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using std::cout;
+using std::endl;
+
+// constants
+const float  SYSTEM_SIZE = 6.0e9f;          // km, out past Neptune
+const float  FOV         = 45.0f;
+const float  ASPECT      = 1.0f;
+const float  CULL_FAR    = 1.0e11f;
+const double MIN_SECONDS = 0.5;             // run each test for at least this long
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// microseconds per call of a test, repeated for at least MIN_SECONDS
+///////////////////////////////////////////////////////////////////////////////
+template <typename Test>
+double timeUs(Test test)
+{
+    int calls = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed;
+    do {
+        test();
+        calls++;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < MIN_SECONDS);
+    return elapsed * 1e6 / calls;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+    std::vector<size_t> counts;
+    for (int i = 1; i < argc; i++)
+        counts.push_back(strtoul(argv[i], NULL, 10));
+    if (counts.empty())
+        counts = {10, 1000, 100000, 1000000};
+
+    glm::vec3 camera(1.5e8f, 1.0e6f, 0);
+    glm::vec3 target(0, 0, 0);
+    glm::vec3 up(0, 0, 1);
+    Frustum frustum;
+    frustum.set(camera, target, up, FOV, ASPECT, 0, CULL_FAR);
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(-SYSTEM_SIZE, SYSTEM_SIZE);
+    std::uniform_real_distribution<float> logRadius(0, 5);
+    for (size_t count : counts) {
+        std::vector<float> x(count), y(count), z(count), radius(count);
+        for (size_t i = 0; i < count; i++) {
+            x[i] = position(random);
+            y[i] = position(random);
+            z[i] = position(random);
+            radius[i] = powf(10, logRadius(random));
+        }
+        std::vector<int> visible(count);
+
+        // Same answer as one sphere at a time
+        size_t visibleCount = frustum.cull(x.data(), y.data(), z.data(), radius.data(), count, visible.data());
+        size_t expected = 0, mismatches = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (frustum.contains(glm::vec3(x[i], y[i], z[i]), radius[i])) {
+                if (expected >= visibleCount || visible[expected] != (int)i)
+                    mismatches++;
+                expected++;
+            }
+        }
+
+        double cullUs = timeUs([&]() {
+            frustum.cull(x.data(), y.data(), z.data(), radius.data(), count, visible.data());
+        });
+
+        // The previous test, centre angle from the view direction against half the fov
+        glm::vec3 forward = glm::normalize(target - camera);
+        size_t angleCount = 0;
+        double angleUs = timeUs([&]() {
+            angleCount = 0;
+            for (size_t i = 0; i < count; i++) {
+                glm::vec3 toBody = glm::normalize(glm::vec3(x[i], y[i], z[i]) - camera);
+                float theta = glm::degrees(acosf(std::min(1.0f, glm::dot(toBody, forward))));
+                angleCount += (theta < FOV / 2);
+            }
+        });
+
+        printf("%8zu bodies: cull %10.2f us (%.2f ns/body), %zu visible, %zu mismatches | angle test %10.2f us, %zu visible\n",
+               count, cullUs, cullUs * 1000 / count, visibleCount, mismatches + (expected != visibleCount), angleUs, angleCount);
+    }
+    return 0;
+}
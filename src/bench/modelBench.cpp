@@ -0,0 +1,99 @@
+///////////////////////////////////////////////////////////////////////////////
+// modelBench.cpp
+// ==============
+// Time of the model's date changes and animation steps, including the Horizons
+// fetches and parsing behind them.
+//
+// usage: modelBench [yyyy-mm-dd ...]
+// Run once with SPACE_RECORD_DIR=<dir> on a machine with network access to
+// record the responses, then with SPACE_REPLAY_DIR=<dir> (and optionally
+// SPACE_REPLAY_LATENCY, SPACE_REPLAY_SEED) anywhere for repeatable numbers.
+// The ephemeris cache is a scratch file unless SPACE_EPHEMERIS_CACHE is set,
+// so every run starts cold.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "../model/model.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+using std::cout;
+using std::endl;
+
+// constants
+const char  *START_DATE       = "2023-03-21";
+const int    ANIMATION_STEPS  = 100000;
+const double ANIMATION_STEP   = 1.0 / 24.0;    // days, same as the viewer's animation
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// milliseconds since a time point
+///////////////////////////////////////////////////////////////////////////////
+double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+    std::vector<std::string> dates;
+    for (int i = 1; i < argc; i++)
+        dates.push_back(argv[i]);
+    if (dates.empty())
+        dates = {"2023-04-01", "2023-12-25", "2024-06-01", "2020-01-01", "2023-03-22"};
+
+    std::string scratchCache;
+    if (getenv("SPACE_EPHEMERIS_CACHE") == NULL) {
+        scratchCache = "/tmp/modelBench-" + std::to_string(getpid()) + ".bin";
+        setenv("SPACE_EPHEMERIS_CACHE", scratchCache.c_str(), 1);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Model *model = new Model(START_DATE);
+    cout << "start (analytic) " << START_DATE << ": " << elapsedMs(start) << " ms" << endl;
+    start = std::chrono::steady_clock::now();
+    model->setDate(START_DATE);
+    cout << "load " << START_DATE << ": " << elapsedMs(start) << " ms" << endl;
+
+    for (std::string &date : dates) {
+        start = std::chrono::steady_clock::now();
+        model->setDate(date);
+        cout << "load " << date << ": " << elapsedMs(start) << " ms" << endl;
+    }
+
+    // Animate inside the window around the last date, which never fetches
+    double jd = model->getJulianDate();
+    int covered = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ANIMATION_STEPS; i++)
+        covered += model->setJulianDate(jd + (i % 240) * ANIMATION_STEP) ? 1 : 0;
+    double animationMs = elapsedMs(start);
+    cout << "animation step: " << animationMs * 1000 / ANIMATION_STEPS << " us ("
+         << covered << "/" << ANIMATION_STEPS << " fully covered)" << endl;
+
+    // Scrub far outside the fetched window, every body comes from the analytic ephemeris
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ANIMATION_STEPS; i++)
+        model->setJulianDate(jd + 5000 + i * ANIMATION_STEP);
+    cout << "analytic step: " << elapsedMs(start) * 1000 / ANIMATION_STEPS << " us" << endl;
+
+    cout << "analytic ephemeris error against the last window (km):" << endl;
+    for (size_t id = 0; id < BODY_COUNT; id++) {
+        KeplerError error = model->getAnalyticError((BodyId)id);
+        printf("  %-8s rms %12.1f  max %12.1f  (%zu samples)\n", BODY_CATALOG[id].name, error.rms, error.max, error.samples);
+    }
+
+    delete model;
+    if (!scratchCache.empty())
+        unlink(scratchCache.c_str());
+    return 0;
+}
@@ -0,0 +1,182 @@
+///////////////////////////////////////////////////////////////////////////////
+// parserBench.cpp
+// ===============
+// Throughput of the Horizons vector table scanner, whole-response and
+// streamed in curl sized chunks, against the previous json::parse based path.
+//
+// usage: parserBench [response.json ...]
+// Recorded Horizons responses are read from the given files. Without files a
+// synthetic multi-year response is generated.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "../model/nasaClient/horizonsParser.hpp"
+#include "../model/nasaClient/json.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+using json = nlohmann::json;
+using std::cout;
+using std::endl;
+
+// constants
+const int    SYNTHETIC_ROWS = 365 * 10;     // ten years of daily rows
+const double MIN_SECONDS    = 1.0;          // run each parser for at least this long
+const size_t CHUNK_SIZE     = 16384;        // CURL_MAX_WRITE_SIZE, largest chunk handed to a write callback
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// build a response shaped like a Horizons VECTORS answer
+///////////////////////////////////////////////////////////////////////////////
+std::string syntheticResponse(int rows)
+{
+    std::stringstream result;
+    result << "*******************************************************************************\n"
+           << " Revised: July 31, 2013             Earth                              399\n\n"
+           << " GEOPHYSICAL PROPERTIES (revised Aug 15, 2018):\n"
+           << "  Vol. Mean Radius (km)    = 6371.01+-0.02   Mass x10^24 (kg)= 5.97219+-0.0006\n"
+           << "  Equ. radius, km          = 6378.137        Mass layers:\n"
+           << "*******************************************************************************\n"
+           << "$$SOE\n";
+    char line[256];
+    for (int i = 0; i < rows; i++) {
+        double t = i * 2 * M_PI / 365.25;
+        snprintf(line, sizeof(line), "%.9f = A.D. 2023-Mar-21 00:00:00.0000 TDB \n", 2460024.5 + i);
+        result << line;
+        snprintf(line, sizeof(line), " X =%22.15E Y =%22.15E Z =%22.15E\n", 1.5e8 * cos(t), 1.5e8 * sin(t), 1e4 * sin(3 * t));
+        result << line;
+        snprintf(line, sizeof(line), " VX=%22.15E VY=%22.15E VZ=%22.15E\n", -29.8 * sin(t), 29.8 * cos(t), 1e-3 * cos(3 * t));
+        result << line;
+        result << " LT= 4.908461058380416E+02 RG= 1.471559186452812E+08 RR=-2.127054549014981E-01\n";
+    }
+    result << "$$EOE\n*******************************************************************************\n";
+
+    json response;
+    response["signature"] = {{"source", "NASA/JPL Horizons API"}, {"version", "1.2"}};
+    response["result"] = result.str();
+    return response.dump();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// previous parser: json::parse, copy the result, find() the tags and atof
+///////////////////////////////////////////////////////////////////////////////
+size_t parseWithJson(const std::string &response)
+{
+    json data = json::parse(response);
+    std::string result = data["result"];
+    size_t rows = 0;
+    size_t end = result.find("$$EOE");
+    size_t index = result.find("X =");
+    double sum = 0;
+    while (index != std::string::npos && index < end) {
+        char values[3][BUFSIZ];
+        size_t y = result.find("Y =", index);
+        size_t z = result.find("Z =", y);
+        size_t vx = result.find("VX=", z);
+        result.copy(values[0], y - index - 4, index + 3);
+        values[0][y - index - 4] = '\0';
+        result.copy(values[1], z - y - 4, y + 3);
+        values[1][z - y - 4] = '\0';
+        result.copy(values[2], vx - z - 5, z + 3);
+        values[2][vx - z - 5] = '\0';
+        sum += atof(values[0]) + atof(values[1]) + atof(values[2]);
+        rows++;
+        index = result.find("X =", vx);
+    }
+    return sum != 0 ? rows : 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// time a parser over all responses, return MB/s
+///////////////////////////////////////////////////////////////////////////////
+template <typename Parse>
+double measure(const std::vector<std::string> &responses, size_t totalBytes, Parse parse, size_t &rows)
+{
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    long iterations = 0;
+    while (elapsed < MIN_SECONDS) {
+        rows = 0;
+        for (const std::string &response : responses)
+            rows += parse(response);
+        iterations++;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return (double)totalBytes * iterations / elapsed / 1e6;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+    std::vector<std::string> responses;
+    for (int i = 1; i < argc; i++) {
+        std::ifstream file(argv[i], std::ios::binary);
+        if (!file) {
+            std::cerr << "Unable to read " << argv[i] << endl;
+            return 1;
+        }
+        std::stringstream ss;
+        ss << file.rdbuf();
+        responses.push_back(ss.str());
+    }
+    if (responses.empty())
+        responses.push_back(syntheticResponse(SYNTHETIC_ROWS));
+
+    size_t totalBytes = 0;
+    for (const std::string &response : responses)
+        totalBytes += response.size();
+    cout << "responses: " << responses.size() << ", " << totalBytes / 1e6 << " MB" << endl;
+
+    // The scanner unescapes in place, so each pass works on a copy made in a reused buffer.
+    // The copy is timed on its own and subtracted.
+    std::vector<char> buffer;
+    HorizonsParser parser;
+    size_t copyRows = 0;
+    double copyRate = measure(responses, totalBytes, [&buffer](const std::string &response) {
+        buffer.assign(response.begin(), response.end());
+        return (size_t)buffer[0];
+    }, copyRows);
+    size_t rows = 0;
+    double scanRate = measure(responses, totalBytes, [&buffer, &parser](const std::string &response) {
+        buffer.assign(response.begin(), response.end());
+        parser.reset();
+        parseHorizonsResponse(buffer.data(), buffer.size(), parser);
+        return parser.getRows().size();
+    }, rows);
+    double scanOnlyRate = 1.0 / (1.0 / scanRate - 1.0 / copyRate);
+
+    HorizonsStream stream;
+    size_t streamRows = 0;
+    double streamRate = measure(responses, totalBytes, [&stream](const std::string &response) {
+        stream.reset();
+        for (size_t offset = 0; offset < response.size(); offset += CHUNK_SIZE) {
+            size_t size = std::min(CHUNK_SIZE, response.size() - offset);
+            stream.write(response.data() + offset, size);
+        }
+        return stream.getParser().getRows().size();
+    }, streamRows);
+
+    size_t jsonRows = 0;
+    double jsonRate = measure(responses, totalBytes, parseWithJson, jsonRows);
+
+    cout << "rows: " << rows << " (stream: " << streamRows << ", json path: " << jsonRows << ")" << endl;
+    cout << "HorizonsParser: " << scanOnlyRate << " MB/s (" << scanRate << " MB/s including the buffer copy)" << endl;
+    cout << "HorizonsStream: " << streamRate << " MB/s in " << CHUNK_SIZE << " byte chunks" << endl;
+    cout << "json::parse:    " << jsonRate << " MB/s" << endl;
+    return 0;
+}
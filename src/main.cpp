@@ -17,16 +17,29 @@
 #endif
 #include <glm/glm.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <iomanip>
 #include <fstream>
+#include <chrono>
 #include <time.h>
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 #include "Bmp.h"
 #include "Sphere.h"
+#include "render/frameProfiler.hpp"
+#include "render/hudText.hpp"
+#include "render/headlessContext.hpp"
+#include "render/frameExporter.hpp"
+#include "render/frustum.hpp"
+#include "render/sphereLod.hpp"
+#include "render/instancedBodies.hpp"
+#include "render/renderManager.hpp"
 #include "model/model.hpp"
+#include "model/nasaClient/julianDate.hpp"
 
 
 
@@ -41,6 +54,7 @@ void mouseMotionCB(int x, int y);
 
 void initGL();
 int  initGLUT(int argc, char **argv);
+void initRenderers();
 bool initSharedMem();
 void clearSharedMem();
 void initLights();
@@ -53,9 +67,17 @@ GLuint loadTexture(const char* fileName, bool wrap=true);
 void zoom(int dir);
 void setFov(float desiredFov);
 void focusCurrentBody(bool zoom);
+void cullBodies();
 void generateModel();
-void getUserDateInput();
+void updateClipRange(glm::vec3 vecCameraBody, glm::vec3 normVecCameraTarget, float bodyRadius, float &near, float &far);
+void drawSmallBodies();
+void drawBodyPoints(const int *ids, size_t count);
+void dateInputKey(unsigned char key);
 void setModelDate(std::string date);
+void advanceAnimation();
+void requestFrame();
+void scheduleUpdates();
+void drawFrameGraph(int x, int y, int width, int height);
 
 // Structs
 typedef struct view {
@@ -63,49 +85,54 @@ typedef struct view {
     float fov = 45.0f;
     bool rezoomOnDateChange = true;
     bool drawLines = false;
+    bool animate = false;
+    bool showProfile = false;           // frame time percentiles and graph on the HUD
+    float animationStep = 1.0f / 24.0f; // days advanced per frame while animating
+    bool placeCamera = true;            // move the camera to the telescope when the first fetched date lands
+    bool rezoomPending = false;         // refocus when the requested date lands
+    bool enteringDate = false;          // keys go to the date input line
+    bool dateInputInvalid = false;
+    std::string dateInput;
     float near;
     float far;
     int nbodies;
     int currentBodyIndex;
     glm::vec3 camera; //Camera Pos
     glm::vec3 target; //Target Pos
-    std::string visibleBodies;
+    std::vector<int> culledBodies;      // bodies inside the frustum, room for all of them
+    std::vector<int> visibleBodies;     // ids drawn in the last frame, target first
+    std::vector<int> visibleLevels;     // sphere level of each visible body in the same order, -1 drawn as a point
+    std::vector<int> pointBodies;       // visible bodies under a pixel
     std::string date;
 } View;
 
+typedef struct headlessFrame {
+    std::string date;
+    int target;                         // body index
+    float fov;                          // degrees, 0 zooms to the target
+} HeadlessFrame;
+
+// Headless rendering (SPACE_HEADLESS)
+int  runHeadless(const char *sequencePath);
+bool readFrameSequence(const char *path, std::vector<HeadlessFrame> &frames);
+void renderHeadlessFrame();
+
 // constants
 const int   SCREEN_WIDTH    = 850;
 const int   SCREEN_HEIGHT   = 850;
 const float CAMERA_DISTANCE = 4.0f;
 const int   TEXT_WIDTH      = 8;
 const int   TEXT_HEIGHT     = 13;
+const int   UPDATE_MS       = 33;       // model polling and animation period while either is active
+const int   GRAPH_WIDTH     = (int)FrameProfiler::HISTORY;   // one pixel per frame
+const int   GRAPH_HEIGHT    = 80;
+const float FRAME_BUDGET_MS = 1000.0f / 60;
+const size_t EXPORT_QUEUE_DEPTH = 8;    // headless frames read back and waiting for a writer
+const float SMALL_BODY_CLIP[2] = {1.0e5f, 1.0e11f};   // km, clip range of the asteroid points
+const float BODY_CULL_RANGE[2] = {0, 1.0e11f};        // km, bodies behind the camera or past this are culled
+const float SMALL_BODY_COLOR[4] = {0.6f, 0.6f, 0.55f, 1};
 std::string IMAGE_PATH = "imgs/";
-std::string viewableBodies[] = {
-    "Earth",
-    "Moon",
-    "Sun",
-    "Mercury",
-    "Venus",
-    "Mars",
-    "Jupiter",
-    "Saturn",
-    "Uranus",
-    "Neptune"
-    };
-std::map<std::string, std::string> texture_info = {
-    {"Earth", "earth.bmp"},
-    {"Moon", "moon.bmp"},
-    {"Sun", "sun.bmp"},
-    {"Mercury", "mercury.bmp"},
-    {"Venus", "venus.bmp"},
-    {"Mars", "mars.bmp"},
-    {"Jupiter", "jupiter.bmp"},
-    {"Saturn", "saturn.bmp"},
-    {"Uranus", "uranus.bmp"},
-    {"Neptune", "neptune.bmp"}
-    };
-
-// How light from the light source is reflected based on the material property
+// How light from the light source is reflected based on the material property, indexed by BodyMaterial
 // {Ka, Kd, Ks, other(shinyness, Unused, Unused, Unused)}
 GLfloat bodyMaterials[][4][4] = {
     {{0.15f, 0.15f, 0.15f, 1}, {0.9f, 0.9f, 0.9f, 1}, {0.0f, 0.0f, 0.0f, 1}, {0, 0, 0, 0}},
@@ -114,6 +141,9 @@ GLfloat bodyMaterials[][4][4] = {
 
 // global variables
 bool firstRender = true;
+bool frameDirty = true;                 // a redisplay is posted and has not been drawn yet
+bool updatesScheduled = false;          // timerCB is armed
+bool headless = false;                  // rendering a frame sequence offscreen, no GLUT window
 void *font = GLUT_BITMAP_8_BY_13;
 int screenWidth;
 int screenHeight;
@@ -131,8 +161,17 @@ std::string date;
 Model *model;
 View *view;
 GLuint *textureIds;
+unsigned int meshRebuilds;              // sphere vertex generations in the last frame, 0 in steady state
+unsigned int trianglesDrawn;            // sphere triangles of the last frame
 
-Sphere sphere(1.0f, 36, 18);           // radius, sectors, stacks, smooth(default)
+SphereLod sphereLod;                    // unit spheres from fine to coarse, one picked per body each frame
+Frustum frustum;                        // view volume of the frame, bodies are culled against it
+HudText hudText;                        // HUD lines from a glyph atlas in one draw
+FrameProfiler profiler;                 // CPU and GPU time of the frame phases (SPACE_FRAME_CSV to log them)
+InstancedBodies instancedBodies;        // every visible body in one draw call, if the context supports it
+RenderManager *renderManager = NULL;    // shader backend (SPACE_RENDERER=shader), NULL on the fixed-function path
+HeadlessContext headlessContext;        // EGL context and framebuffer of the headless mode
+FrameExporter frameExporter;            // headless frames to BMP files, read back and written in the background
 
 
 
@@ -142,18 +181,21 @@ int main(int argc, char **argv)
     // init global vars
     initSharedMem();
 
+    // A frame sequence to render offscreen, without GLUT or a display
+    const char *sequencePath = getenv("SPACE_HEADLESS");
+    if (sequencePath != NULL)
+        return runHeadless(sequencePath);
+
     // init GLUT and GL
     initGLUT(argc, argv);
     initGL();
+    initRenderers();
 
-    // load BMP image
-    for (int i = 0; i<view->nbodies; i++) {
-        std::string name = viewableBodies[i];
-        Body *body = model->getBody(name);
-        std::string imagePath = IMAGE_PATH + texture_info[name];
-        textureIds[i] = loadTexture(imagePath.c_str());
-        body->setTexId(textureIds[i]);
-    }
+    if (!hudText.init(font, TEXT_WIDTH, TEXT_HEIGHT))
+        std::cout << "Glyph atlas unavailable, drawing the HUD per character" << std::endl;
+
+    const char *frameCsv = getenv("SPACE_FRAME_CSV");
+    profiler.init((frameCsv != NULL) ? frameCsv : "");
 
     // the last GLUT call (LOOP)
     // window will be shown and display callback is triggered by events
@@ -165,6 +207,39 @@ int main(int argc, char **argv)
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// load the body textures and set up the body renderer of the current context
+///////////////////////////////////////////////////////////////////////////////
+void initRenderers()
+{
+    // load BMP image
+    for (int i = 0; i<view->nbodies; i++) {
+        std::string imagePath = IMAGE_PATH + BODY_CATALOG[i].texture;
+        textureIds[i] = loadTexture(imagePath.c_str());
+        model->getBody((BodyId)i)->setTexId(textureIds[i]);
+        model->getStore().setTexId(i, textureIds[i]);
+    }
+
+    // the same images as layers of one texture array for the instanced path
+    std::vector<std::string> imagePaths;
+    for (int i = 0; i < view->nbodies; i++)
+        imagePaths.push_back(IMAGE_PATH + BODY_CATALOG[i].texture);
+    size_t materialCount = sizeof(bodyMaterials) / sizeof(bodyMaterials[0]);
+    const char *renderer = getenv("SPACE_RENDERER");
+    if (renderer != NULL && strcmp(renderer, "shader") == 0) {
+        renderManager = new RenderManager();
+        if (!renderManager->init(sphereLod, imagePaths, bodyMaterials, materialCount)) {
+            std::cout << "Shader renderer unavailable, using fixed-function rendering" << std::endl;
+            delete renderManager;
+            renderManager = NULL;
+        }
+    }
+    if (renderManager == NULL && !instancedBodies.init(sphereLod, imagePaths, bodyMaterials, materialCount))
+        std::cout << "Instanced rendering unavailable, drawing bodies one by one" << std::endl;
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // initialize GLUT for windowing
 ///////////////////////////////////////////////////////////////////////////////
@@ -188,7 +263,7 @@ int initGLUT(int argc, char **argv)
 
     // register GLUT callback functions
     glutDisplayFunc(displayCB);
-    glutTimerFunc(33, timerCB, 33);             // redraw only every given millisec
+    scheduleUpdates();                          // the timer only runs while animating or loading
     glutReshapeFunc(reshapeCB);
     glutKeyboardFunc(keyboardCB);
     glutSpecialFunc(specialKeyboardCB);
@@ -217,6 +292,7 @@ void initGL()
     glEnable(GL_LIGHTING);
     glEnable(GL_TEXTURE_2D);
     glEnable(GL_CULL_FACE);
+    glEnable(GL_NORMALIZE);                     // bodies scale the unit sphere
 
     // track material ambient and diffuse from surface color, call it before glEnable(GL_COLOR_MATERIAL)
     //glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
@@ -228,6 +304,10 @@ void initGL()
     glDepthFunc(GL_LEQUAL);
 
     initLights();
+
+    // the sphere meshes live in GPU buffers from here on, if the context supports them
+    if (!sphereLod.createBuffers())
+        std::cout << "Sphere buffers unavailable, drawing from client vertex arrays" << std::endl;
 }
 
 
@@ -304,15 +384,16 @@ bool initSharedMem()
     view = new View();
     view->date = "2023-03-21";
     model = new Model(view->date);
-    view->nbodies = end(viewableBodies) - begin(viewableBodies);
+    view->nbodies = VIEWABLE_BODY_COUNT;
+    view->culledBodies.resize(view->nbodies);
+    view->visibleBodies.reserve(view->nbodies);
+    view->visibleLevels.reserve(view->nbodies);
+    view->pointBodies.reserve(view->nbodies);
     textureIds = (GLuint *)malloc(sizeof(GLuint) * view->nbodies);
-    for (int i = 0; i < view->nbodies; i++) {
-        std::string name = viewableBodies[i];
-    }
-    
+
     view->currentBodyIndex = 0;
-    view->camera = model->getBody("JWS")->getPos();
-    view->target = model->getBody(viewableBodies[view->currentBodyIndex])->getPos();
+    view->camera = model->getStore().getPos(BODY_JWS);
+    view->target = model->getStore().getPos(view->currentBodyIndex);
 
     return true;
 }
@@ -324,6 +405,15 @@ bool initSharedMem()
 ///////////////////////////////////////////////////////////////////////////////
 void clearSharedMem()
 {
+    if (renderManager != NULL) {
+        renderManager->release();
+        delete renderManager;
+        renderManager = NULL;
+    }
+    instancedBodies.release();
+    sphereLod.releaseBuffers();
+    hudText.release();
+    profiler.release();
 }
 
 
@@ -343,11 +433,13 @@ void initLights()
     glLightfv(GL_LIGHT0, GL_SPECULAR, lightKs);
 
     // position the light
-    glm::vec3 sunPos = model->getBody("Sun")->getPos();
+    glm::vec3 sunPos = model->getStore().getPos(BODY_SUN);
     float lightPos[4] = {sunPos.x, sunPos.y, sunPos.z, 1};
     glLightfv(GL_LIGHT0, GL_POSITION, lightPos);
     float lightAttenuation = 0.000000001f;
     glLightfv(GL_LIGHT0, GL_LINEAR_ATTENUATION, &lightAttenuation);
+    if (renderManager != NULL)
+        renderManager->setLight(sunPos, lightKa, lightKd, lightKs, glm::vec3(1, lightAttenuation, 0));
 
     glEnable(GL_LIGHT0);                        // MUST enable each light source after configuration
 }
@@ -362,6 +454,8 @@ void setCamera(glm::vec3 cameraPos, glm::vec3 target)
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
     gluLookAt(cameraPos.x, cameraPos.y, cameraPos.z, target.x, target.y, target.z, 0, 0, 1); // eye(x,y,z), focal(x,y,z), up(x,y,z)
+    if (renderManager != NULL)
+        renderManager->setView(cameraPos, target, glm::vec3(0, 0, 1));
 }
 
 
@@ -459,58 +553,101 @@ void showInfo()
     ss << std::fixed << std::setprecision(3);
 
     int line = 1;
+    size_t slot = 0;                    // HUD text line, unchanged lines are not tessellated again
+
+    ss << "Date: " << view->date;
+    if (model->isLoading())
+        ss << " (loading " << model->getLoadingDate() << "...)";
+    if (model->isPropagating())
+        ss << " (N-body propagation)";
+    hudText.setLine(slot++, ss.str(), 1, screenHeight-(line++ * TEXT_HEIGHT), color);
+    ss.str("");
 
-    ss << "Date: " << view->date << std::ends;
-    drawString(ss.str().c_str(), 1, screenHeight-(line++ * TEXT_HEIGHT), color, font);
+    if (view->enteringDate) {
+        if (view->dateInputInvalid)
+            ss << "Invalid Date, ";
+        ss << "Enter a Date (yyyy-mm-dd): " << view->dateInput << "_";
+        hudText.setLine(slot++, ss.str(), 1, screenHeight-(line++ * TEXT_HEIGHT), color);
+        ss.str("");
+    }
+
+    ss << "Current Target: " << BODY_CATALOG[view->currentBodyIndex].name;
+    hudText.setLine(slot++, ss.str(), 1, screenHeight-(line++ * TEXT_HEIGHT), color);
     ss.str("");
 
-    ss << "Current Target: " << viewableBodies[view->currentBodyIndex] << std::ends;
-    drawString(ss.str().c_str(), 1, screenHeight-(line++ * TEXT_HEIGHT), color, font);
+    ss << "FOV (deg): " << view->fov;
+    hudText.setLine(slot++, ss.str(), 1, screenHeight-(line++ * TEXT_HEIGHT), color);
     ss.str("");
 
-    ss << "FOV (deg): " << view->fov << std::ends;
-    drawString(ss.str().c_str(), 1, screenHeight-(line++ * TEXT_HEIGHT), color, font);
+    ss << "Visible Bodies: ";
+    for (size_t i = 0; i < view->visibleBodies.size(); i++)
+        ss << ((i > 0) ? ", " : "") << BODY_CATALOG[view->visibleBodies[i]].name;
+    hudText.setLine(slot++, ss.str(), 1, screenHeight-(line++ * TEXT_HEIGHT), color);
     ss.str("");
 
-    ss << "Visible Bodies: " << view->visibleBodies << std::ends;
-    drawString(ss.str().c_str(), 1, screenHeight-(line++ * TEXT_HEIGHT), color, font);
+    ss << "Mesh Rebuilds Last Frame: " << meshRebuilds;
+    hudText.setLine(slot++, ss.str(), 1, screenHeight-(line++ * TEXT_HEIGHT), color);
+    ss.str("");
+
+    ss << "Triangles Last Frame: " << trianglesDrawn << ", Point Bodies: " << view->pointBodies.size();
+    hudText.setLine(slot++, ss.str(), 1, screenHeight-(line++ * TEXT_HEIGHT), color);
     ss.str("");
 
     std::string rezoom = (view->rezoomOnDateChange) ? "true" : "false";
-    ss << "Zoom to Target on Date Change: " << rezoom << std::ends;
-    drawString(ss.str().c_str(), 1, screenHeight-(line++ * TEXT_HEIGHT), color, font);
+    ss << "Zoom to Target on Date Change: " << rezoom;
+    hudText.setLine(slot++, ss.str(), 1, screenHeight-(line++ * TEXT_HEIGHT), color);
     ss.str("");
 
 
     // Controls
     line++; // Add Blank line
-    ss << "CONTROLS" << std::ends;
-    drawString(ss.str().c_str(), 1, screenHeight-(line++ * TEXT_HEIGHT), color, font);
-    ss.str("");
+    hudText.setLine(slot++, "CONTROLS", 1, screenHeight-(line++ * TEXT_HEIGHT), color);
 
-    ss << "Scroll Wheel = Zoom" << std::ends;
-    drawString(ss.str().c_str(), 1, screenHeight-(line++ * TEXT_HEIGHT), color, font);
-    ss.str("");
+    hudText.setLine(slot++, "Scroll Wheel = Zoom", 1, screenHeight-(line++ * TEXT_HEIGHT), color);
 
-    ss << "Left/Right Arrow = Change Target" << std::ends;
-    drawString(ss.str().c_str(), 1, screenHeight-(line++ * TEXT_HEIGHT), color, font);
-    ss.str("");
+    hudText.setLine(slot++, "Left/Right Arrow = Change Target", 1, screenHeight-(line++ * TEXT_HEIGHT), color);
 
-    ss << "` = Change Date" << std::ends;
-    drawString(ss.str().c_str(), 1, screenHeight-(line++ * TEXT_HEIGHT), color, font);
-    ss.str("");
+    hudText.setLine(slot++, "` = Change Date (Enter = Apply, Esc = Cancel)", 1, screenHeight-(line++ * TEXT_HEIGHT), color);
 
-    ss << "Space = Refocus to Target" << std::ends;
-    drawString(ss.str().c_str(), 1, screenHeight-(line++ * TEXT_HEIGHT), color, font);
-    ss.str("");
+    hudText.setLine(slot++, "Space = Refocus to Target", 1, screenHeight-(line++ * TEXT_HEIGHT), color);
 
-    ss << "R = Toggle Refocus on Date Change" << std::ends;
-    drawString(ss.str().c_str(), 1, screenHeight-(line++ * TEXT_HEIGHT), color, font);
-    ss.str("");
+    hudText.setLine(slot++, "R = Toggle Refocus on Date Change", 1, screenHeight-(line++ * TEXT_HEIGHT), color);
 
-    ss << "D = Display Sphere Render Lines" << std::ends;
-    drawString(ss.str().c_str(), 1, screenHeight-(line++ * TEXT_HEIGHT), color, font);
-    ss.str("");
+    hudText.setLine(slot++, "D = Display Sphere Render Lines", 1, screenHeight-(line++ * TEXT_HEIGHT), color);
+
+    hudText.setLine(slot++, "A = Toggle Time Animation", 1, screenHeight-(line++ * TEXT_HEIGHT), color);
+
+    hudText.setLine(slot++, "N = Toggle N-Body Propagation", 1, screenHeight-(line++ * TEXT_HEIGHT), color);
+
+    hudText.setLine(slot++, "P = Toggle Frame Times", 1, screenHeight-(line++ * TEXT_HEIGHT), color);
+
+    // Frame times, percentiles over the last frames and a graph in the bottom right corner
+    if (view->showProfile) {
+        line = 1;
+        ss << "Frame CPU p50/p95/p99 (ms): " << profiler.getPercentile(50, false) << " / "
+           << profiler.getPercentile(95, false) << " / " << profiler.getPercentile(99, false);
+        hudText.setLine(slot++, ss.str(), 1, line++ * TEXT_HEIGHT, color);
+        ss.str("");
+
+        if (profiler.hasGpuTimers())
+            ss << "Frame GPU p50/p95/p99 (ms): " << profiler.getPercentile(50, true) << " / "
+               << profiler.getPercentile(95, true) << " / " << profiler.getPercentile(99, true);
+        else
+            ss << "Frame GPU: no timer queries";
+        hudText.setLine(slot++, ss.str(), 1, line++ * TEXT_HEIGHT, color);
+        ss.str("");
+
+        ss << "Phases CPU|GPU (ms):";
+        for (int p = 0; p < PHASE_COUNT; p++)
+            ss << " " << PHASE_NAMES[p] << " " << profiler.getPhaseTime((FramePhase)p, false) << "|"
+               << profiler.getPhaseTime((FramePhase)p, true);
+        hudText.setLine(slot++, ss.str(), 1, line++ * TEXT_HEIGHT, color);
+        ss.str("");
+
+        drawFrameGraph(screenWidth - GRAPH_WIDTH - 1, 1, GRAPH_WIDTH, GRAPH_HEIGHT);
+    }
+    hudText.setLineCount(slot);
+    hudText.draw();
 
     // unset floating format
     ss << std::resetiosflags(std::ios_base::fixed | std::ios_base::floatfield);
@@ -557,6 +694,8 @@ void toPerspective(float fov, float near, float far)
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
     gluPerspective(fov, (float)(screenWidth)/screenHeight, near, far); // FOV, AspectRatio, NearClip, FarClip
+    if (renderManager != NULL)
+        renderManager->setProjection(fov, (float)(screenWidth)/screenHeight, near, far);
 
     // switch to modelview matrix in order to set scene
     glMatrixMode(GL_MODELVIEW);
@@ -583,21 +722,32 @@ void displayCB()
         focusCurrentBody(true);
     }
 
+    profiler.beginFrame();
+    profiler.beginPhase(PHASE_CULL);
+    cullBodies();
+
     // clear bufferd
+    profiler.beginPhase(PHASE_DRAW);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
     // Copy current GL_MODELVIEW
     glPushMatrix();
 
     // // draw right sphere with texture
+    unsigned int buildCount = sphereLod.getBuildCount();
     generateModel();
+    meshRebuilds = sphereLod.getBuildCount() - buildCount;
 
+    profiler.beginPhase(PHASE_HUD);
     showInfo();     // print max range of glDrawRangeElements
 
     // return updated
     glPopMatrix();
 
+    profiler.beginPhase(PHASE_SWAP);
     glutSwapBuffers();
+    profiler.endFrame();
+    frameDirty = false;
 }
 
 
@@ -606,6 +756,7 @@ void reshapeCB(int w, int h)
     screenWidth = w;
     screenHeight = h;
     toPerspective(view->fov, view->near, view->far);
+    requestFrame();
     std::cout << "window resized: " << w << " x " << h << std::endl;
 
 #ifdef _WIN32
@@ -623,13 +774,37 @@ void reshapeCB(int w, int h)
 
 void timerCB(int millisec)
 {
-    glutTimerFunc(millisec, timerCB, millisec);
-    glutPostRedisplay();
+    updatesScheduled = false;
+
+    // Pick up a date change completed by the model's worker thread, never wait for one.
+    // The model already shows the requested date analytically, so an animation carries on from where it is.
+    double jd = model->getJulianDate();
+    if (model->update()) {
+        if (view->animate)
+            model->setJulianDate(jd);
+        view->date = model->getDate();
+        if (view->placeCamera)
+            view->camera = model->getStore().getPos(BODY_JWS);
+        focusCurrentBody(view->rezoomPending || view->placeCamera);
+        view->rezoomPending = false;
+        view->placeCamera = false;
+    }
+
+    if (view->animate)
+        advanceAnimation();
+    scheduleUpdates();
 }
 
 
 void keyboardCB(unsigned char key, int x, int y)
 {
+    if (view->enteringDate) {
+        dateInputKey(key);
+        requestFrame();
+        scheduleUpdates();
+        return;
+    }
+
     switch(key)
     {
     case 27: // ESCAPE
@@ -645,8 +820,22 @@ void keyboardCB(unsigned char key, int x, int y)
     case 'R':
         view->rezoomOnDateChange = !view->rezoomOnDateChange;
         break;
+    case 'a':
+    case 'A':
+        view->animate = !view->animate;
+        break;
+    case 'n':
+    case 'N':
+        model->setPropagation(!model->isPropagating());
+        break;
+    case 'p':
+    case 'P':
+        view->showProfile = !view->showProfile;
+        break;
     case '`':
-        getUserDateInput();
+        view->enteringDate = true;
+        view->dateInputInvalid = false;
+        view->dateInput = "";
         break;
 
     case ' ':
@@ -662,6 +851,10 @@ void keyboardCB(unsigned char key, int x, int y)
         view->currentBodyIndex = numCheck;
         focusCurrentBody(true);
     }
+
+    // Every key may toggle something shown, animating or a new date keeps the timer going
+    requestFrame();
+    scheduleUpdates();
 }
 
 void specialKeyboardCB(int key, int x, int y) {
@@ -760,14 +953,14 @@ void setFov(float desiredFov) {
     if (desiredFov > view->fovLimits[1])
         desiredFov = view->fovLimits[1];
     view->fov = desiredFov;
+    requestFrame();
 }
 
 void focusCurrentBody(bool zoom) {    
-    std::string targetName = viewableBodies[view->currentBodyIndex];
-    Body *target = model->getBody(targetName);
-    view->target = target->getPos();
+    BodyStore &store = model->getStore();
+    view->target = store.getPos(view->currentBodyIndex);
     glm::vec3 vecCameraTarget = view->target - view->camera;
-    float desiredFov = glm::degrees(atan2(4*target->getRadius(), glm::length(vecCameraTarget)));
+    float desiredFov = glm::degrees(atan2(4*store.getRadius()[view->currentBodyIndex], glm::length(vecCameraTarget)));
 
     //Update camera target
     setCamera(view->camera, view->target);
@@ -776,106 +969,419 @@ void focusCurrentBody(bool zoom) {
     
     if (zoom)
         setFov(desiredFov);
+    requestFrame();
 }
 
 
+void cullBodies() {
+    // Bounding spheres against the six planes of the view, the target first and always drawn
+    BodyStore &store = model->getStore();
+    int targetId = view->currentBodyIndex;
+    frustum.set(view->camera, view->target, glm::vec3(0, 0, 1), view->fov, (float)(screenWidth)/screenHeight,
+                BODY_CULL_RANGE[0], BODY_CULL_RANGE[1]);
+    size_t culledCount = frustum.cull(store.getX(), store.getY(), store.getZ(), store.getRadius(), view->nbodies,
+                                      view->culledBodies.data());
+    view->visibleBodies.clear();
+    view->visibleBodies.push_back(targetId);
+    for (size_t k = 0; k < culledCount; k++) {
+        if (view->culledBodies[k] != targetId)
+            view->visibleBodies.push_back(view->culledBodies[k]);
+    }
+}
+
 void generateModel() {
-    std::string targetName = viewableBodies[view->currentBodyIndex];
-    Body *target = model->getBody(targetName);
-    glm::vec3 vecCameraTarget = target->getPos() - view->camera;
+    // Walk the body arrays by id, no name lookups or string building per frame
+    BodyStore &store = model->getStore();
+    const float *x = store.getX();
+    const float *y = store.getY();
+    const float *z = store.getZ();
+    const float *radius = store.getRadius();
+    const unsigned int *texIds = store.getTexId();
+    const unsigned char *materials = store.getMaterial();
+
+    int targetId = view->currentBodyIndex;
+    glm::vec3 vecCameraTarget = store.getPos(targetId) - view->camera;
     glm::vec3 normVecCameraTarget = glm::normalize(vecCameraTarget);
-    view->visibleBodies = targetName;
+    view->visibleLevels.clear();
+    view->pointBodies.clear();
+    trianglesDrawn = 0;
+
+    float near = glm::length(vecCameraTarget) - 2 * radius[targetId];
+    float far = glm::length(vecCameraTarget) + 2 * radius[targetId];
+    bool instanced = (renderManager != NULL || instancedBodies.isReady()) && !view->drawLines;
+    drawSmallBodies();
+    for (int i : view->visibleBodies) {
+        glm::vec3 bodyPos(x[i], y[i], z[i]);
+        glm::vec3 vecCameraBody = bodyPos - view->camera;
+        float bodyRadius = radius[i];
+
+        // Tessellation from the size on screen, a body under a pixel is only a point
+        float pixels = SphereLod::screenRadius(bodyRadius, glm::length(vecCameraBody), view->fov, screenHeight);
+        int level = sphereLod.select(pixels);
+        view->visibleLevels.push_back(level);
+        if (level < 0) {
+            view->pointBodies.push_back(i);
+            continue;
+        }
+        trianglesDrawn += sphereLod.getLevel(level).getTriangleCount();
+        updateClipRange(vecCameraBody, normVecCameraTarget, bodyRadius, near, far);
+    }
 
-    float near = glm::length(vecCameraTarget) - 2 * target->getRadius();
-    float far = glm::length(vecCameraTarget) + 2 * target->getRadius();
-    for (int i = 0; i < view->nbodies; i++) {
-        std::string name = viewableBodies[i];
-        Body *body = model->getBody(name);
-        glm::vec3 bodyPos = body->getPos();
+    // Clip range of this frame before anything is drawn with it, a frame drawn once (headless, or
+    // redrawn only on change) must not use the range of the one before. toPerspective resets the modelview.
+    view->near = near;
+    view->far = far;
+    glPushMatrix();
+    toPerspective(view->fov, near, far);
+    glPopMatrix();
 
-        glm::vec3 vecCameraBody = bodyPos - view->camera;
-        glm::vec3 normVecCameraBody = glm::normalize(vecCameraBody);
+    for (size_t k = 0; k < view->visibleBodies.size() && !instanced; k++) {
+        int i = view->visibleBodies[k];
+        int level = view->visibleLevels[k];
+        if (level < 0)
+            continue;
+        glm::vec3 bodyPos(x[i], y[i], z[i]);
+        float bodyRadius = radius[i];
+
+        // set material
+        int materialIndex = materials[i];
+
+        glMaterialfv(GL_FRONT, GL_AMBIENT,   bodyMaterials[materialIndex][0]);
+        glMaterialfv(GL_FRONT, GL_DIFFUSE,   bodyMaterials[materialIndex][1]);
+        glMaterialfv(GL_FRONT, GL_SPECULAR,  bodyMaterials[materialIndex][2]);
+        glMaterialf(GL_FRONT, GL_SHININESS, bodyMaterials[materialIndex][3][0]);
+
+        //Model item and apply texture
+        GLuint texId = texIds[i];
+        // One unit mesh for every body, scaled by the transform (GL_NORMALIZE keeps the lighting right)
+        glPushMatrix();
+        glTranslatef(bodyPos.x, bodyPos.y, bodyPos.z);
+        glScalef(bodyRadius, bodyRadius, bodyRadius);
+        glBindTexture(GL_TEXTURE_2D, texId);
+        if (view->drawLines) {
+            float lineColor[4] = {1, 1, 1, 0.2f};
+            sphereLod.getLevel(level).drawWithLines(lineColor);
+        } else {
+            sphereLod.getLevel(level).draw();
+        }
+        glPopMatrix();
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // One draw per level for every visible body, the target first as in the per body path
+    if (instanced && renderManager != NULL)
+        renderManager->render(x, y, z, radius, materials, view->visibleBodies.data(), view->visibleLevels.data(), view->visibleBodies.size());
+    else if (instanced)
+        instancedBodies.draw(x, y, z, radius, materials, view->visibleBodies.data(), view->visibleLevels.data(), view->visibleBodies.size());
+    drawBodyPoints(view->pointBodies.data(), view->pointBodies.size());
+}
 
-        float dotProduct = glm::dot(normVecCameraBody, normVecCameraTarget);
-        if (dotProduct >= 1)
-            dotProduct = 1;
-        else if (dotProduct <= -1)
-            dotProduct = M_PI;
+void updateClipRange(glm::vec3 vecCameraBody, glm::vec3 normVecCameraTarget, float bodyRadius, float &near, float &far) {
+    // Update Frustom
+    // Project body vector onto target normal vector
+    float projDistance = glm::dot(vecCameraBody, normVecCameraTarget);
+    if (projDistance < near)
+        near = projDistance - 3*bodyRadius;
+    else if (projDistance > far)
+        far = projDistance + 3*bodyRadius;
+}
 
-        float theta = glm::degrees(acos(dotProduct));
+void drawSmallBodies() {
+    // One vertex array straight from the model, behind the bodies and outside their tight clip range
+    SmallBodies &smallBodies = model->getSmallBodies();
+    if (smallBodies.size() == 0)
+        return;
+    glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT | GL_POINT_BIT);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_TEXTURE_2D);
+    glDisable(GL_DEPTH_TEST);
+    glColor4fv(SMALL_BODY_COLOR);
+    glPointSize(1);
 
-        //Deal with floating point error calcualtion
-        if (name == targetName) {
-            theta = 0;
-        }
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    gluPerspective(view->fov, (float)(screenWidth)/screenHeight, SMALL_BODY_CLIP[0], SMALL_BODY_CLIP[1]);
+    glMatrixMode(GL_MODELVIEW);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, smallBodies.getPoints());
+    glDrawArrays(GL_POINTS, 0, (GLsizei)smallBodies.size());
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopAttrib();
+}
 
-        if ((theta >= 0) && (theta < (view->fov/2))) {
-            if (name != targetName) {
-                view->visibleBodies += ", " + name;
-            }
-
-            // set material
-            int materialIndex;
-            if (name == "Sun") {
-                materialIndex = 1;
-            } else {
-                materialIndex = 0;
-            }
-
-            glMaterialfv(GL_FRONT, GL_AMBIENT,   bodyMaterials[materialIndex][0]);
-            glMaterialfv(GL_FRONT, GL_DIFFUSE,   bodyMaterials[materialIndex][1]);
-            glMaterialfv(GL_FRONT, GL_SPECULAR,  bodyMaterials[materialIndex][2]);
-            glMaterialf(GL_FRONT, GL_SHININESS, bodyMaterials[materialIndex][3][0]);
-
-            //Model item and apply texture
-            float bodyRadius = body->getRadius();
-            GLuint texId = textureIds[i];
-            glPushMatrix();
-            glTranslatef(bodyPos.x, bodyPos.y, bodyPos.z);
-            glBindTexture(GL_TEXTURE_2D, texId);
-            sphere.setRadius(bodyRadius);
-            if (view->drawLines) {
-                float lineColor[4] = {1, 1, 1, 0.2f};
-                sphere.drawWithLines(lineColor);
-            } else {
-                sphere.draw();
-            }
-            glPopMatrix();
-
-            // Update Frustom
-            // Project body vector onto target normal vector
-            float projDistance = glm::dot(vecCameraBody, normVecCameraTarget);
-            if (projDistance < near)
-                near = projDistance - 3*bodyRadius;
-            else if (projDistance > far)
-                far = projDistance + 3*bodyRadius;
+void drawBodyPoints(const int *ids, size_t count) {
+    // Bodies under a pixel in their catalog color, with the clip range of the asteroid points
+    // so they do not widen the one of the bodies. Without a shared depth range a point can show over
+    // a sphere it is behind, at most a couple of pixels.
+    if (count == 0)
+        return;
+    BodyStore &store = model->getStore();
+    glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT | GL_POINT_BIT);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_TEXTURE_2D);
+    glDisable(GL_DEPTH_TEST);
+    glPointSize(2);
+
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    gluPerspective(view->fov, (float)(screenWidth)/screenHeight, SMALL_BODY_CLIP[0], SMALL_BODY_CLIP[1]);
+    glMatrixMode(GL_MODELVIEW);
+
+    glBegin(GL_POINTS);
+    for (size_t i = 0; i < count; i++) {
+        int id = ids[i];
+        glColor3fv(BODY_CATALOG[id].color);
+        glVertex3f(store.getX()[id], store.getY()[id], store.getZ()[id]);
+    }
+    glEnd();
+
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopAttrib();
+}
+
+void dateInputKey(unsigned char key) {
+    switch (key) {
+    case 27: // ESCAPE cancels the input
+        view->enteringDate = false;
+        break;
+    case 8:   // BACKSPACE
+    case 127: // DELETE
+        if (!view->dateInput.empty())
+            view->dateInput.pop_back();
+        break;
+    case '\r':
+    case '\n': {
+        CalendarDate calendarDate;
+        if (!julian::parseCalendar(view->dateInput.c_str(), calendarDate)) {
+            view->dateInputInvalid = true;
+            view->dateInput = "";
+            break;
         }
+        view->enteringDate = false;
+        setModelDate(view->dateInput);
+        break;
     }
-    glBindTexture(GL_TEXTURE_2D, 0);
+    default:
+        if (((key >= '0' && key <= '9') || key == '-') && view->dateInput.size() < 16)
+            view->dateInput += key;
+    }
+}
 
-    view->near = near;
-    view->far = far;
-    toPerspective(view->fov, near, far);
+void setModelDate(std::string date) {
+    // The worker thread fetches the date, timerCB swaps it in when it is complete
+    if (!model->requestDate(date))
+        return;
+    view->date = model->getDate();
+    view->rezoomPending = view->rezoomOnDateChange;
+    focusCurrentBody(view->rezoomPending);
+}
+
+void drawFrameGraph(int x, int y, int width, int height) {
+    // CPU frame times in white, GPU in green, against the 60 Hz budget in red, in the current 2D projection
+    std::vector<float> cpu = profiler.getHistory(false);
+    std::vector<float> gpu = profiler.getHistory(true);
+    float scale = FRAME_BUDGET_MS * 2;
+    for (float ms : cpu)
+        scale = std::max(scale, ms);
+    glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_TEXTURE_2D);
+    glDisable(GL_DEPTH_TEST);
+
+    glColor4f(0, 0, 0, 1);
+    glRectf(x, y, x + width, y + height);
+    glBegin(GL_LINES);
+    glColor4f(1, 0, 0, 1);
+    glVertex2f(x, y + height * FRAME_BUDGET_MS / scale);
+    glVertex2f(x + width, y + height * FRAME_BUDGET_MS / scale);
+    glEnd();
+
+    const std::vector<float> *series[2] = {&cpu, &gpu};
+    const float colors[2][4] = {{1, 1, 1, 1}, {0.3f, 1, 0.3f, 1}};
+    for (int s = 0; s < 2; s++) {
+        const std::vector<float> &times = *series[s];
+        glColor4fv(colors[s]);
+        glBegin(GL_LINE_STRIP);
+        for (size_t i = 0; i < times.size(); i++)
+            glVertex2f(x + width - (float)times.size() + i, y + height * times[i] / scale);
+        glEnd();
+    }
+    glPopAttrib();
+}
+
+void requestFrame() {
+    // Draw once for any number of changes before the next frame, the headless loop draws every frame itself
+    if (frameDirty || headless)
+        return;
+    frameDirty = true;
+    glutPostRedisplay();
 }
 
-void getUserDateInput() {
-    std::string desiredDate;
-    std::cout << "Enter a Desired Date (yyyy-mm-dd): ";
-    std::cin >> desiredDate;
+void scheduleUpdates() {
+    // Poll the model only while a date is loading or the animation runs, an idle view sleeps in GLUT
+    if (updatesScheduled || !(view->animate || model->isLoading()))
+        return;
+    updatesScheduled = true;
+    glutTimerFunc(UPDATE_MS, timerCB, UPDATE_MS);
+}
+
+void advanceAnimation() {
+    static std::string fetchedDay;
+    double jd = model->getJulianDate() + view->animationStep;
+    if (!model->setJulianDate(jd) && !model->isLoading()) {
+        // Left the prefetched window, the analytic ephemeris fills in while the window around the new day
+        // is fetched in the background (once per day, as some bodies may not be covered at all)
+        CalendarDate calendarDate = julian::toCalendar(jd);
+        char date[16];
+        snprintf(date, sizeof(date), "%04ld-%02d-%02d", calendarDate.year, calendarDate.month, calendarDate.day);
+        if (fetchedDay != date) {
+            fetchedDay = date;
+            model->requestDate(date);
+            model->setJulianDate(jd);
+        }
+    }
+    view->date = model->getDate();
+    focusCurrentBody(false);
+}
+
+
+//=============================================================================
+// HEADLESS RENDERING
+//=============================================================================
 
-    struct tm tm;
-    while (strptime(desiredDate.c_str(), "%Y-%m-%d", &tm) == NULL) {
-        std::cout << "Invalid Date" << std::endl;
-        std::cout << "Enter a Date in the format yyyy-mm-dd: ";
-        std::cin >> desiredDate;
+int runHeadless(const char *sequencePath) {
+    // SPACE_HEADLESS names a frame sequence, each frame is written as frameNNNNN.bmp into SPACE_HEADLESS_DIR
+    // (the working directory by default) at SPACE_HEADLESS_SIZE (WIDTHxHEIGHT, the window size by default),
+    // by SPACE_HEADLESS_WRITERS threads (half the cores by default, llvmpipe rasterizes on the others)
+    headless = true;
+    std::vector<HeadlessFrame> frames;
+    if (!readFrameSequence(sequencePath, frames))
+        return 1;
+    const char *size = getenv("SPACE_HEADLESS_SIZE");
+    if (size != NULL && (sscanf(size, "%dx%d", &screenWidth, &screenHeight) != 2 || screenWidth <= 0 || screenHeight <= 0)) {
+        std::cerr << "SPACE_HEADLESS_SIZE must be WIDTHxHEIGHT, not " << size << std::endl;
+        return 1;
+    }
+    const char *outputDir = getenv("SPACE_HEADLESS_DIR");
+    std::string outputPrefix = (outputDir != NULL) ? std::string(outputDir) + "/" : "";
+    const char *writers = getenv("SPACE_HEADLESS_WRITERS");
+    size_t writerCount = (writers != NULL) ? strtoul(writers, NULL, 10) : std::thread::hardware_concurrency() / 2;
+    if (!headlessContext.init(screenWidth, screenHeight)) {
+        std::cerr << "Headless rendering unavailable" << std::endl;
+        return 1;
+    }
+    initGL();
+    initRenderers();
+    frameExporter.init(screenWidth, screenHeight, std::max(writerCount, (size_t)1), EXPORT_QUEUE_DEPTH);
+    if (!frameExporter.hasAsyncReadback())
+        std::cout << "Pixel buffers unavailable, reading frames back synchronously" << std::endl;
+
+    std::string loadedDate;
+    double loadSeconds = 0, renderSeconds = 0;
+    for (size_t i = 0; i < frames.size(); i++) {
+        const HeadlessFrame &frame = frames[i];
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if (frame.date != loadedDate) {
+            // Wait for the date as a batch job has nothing else to do, the camera rides on the telescope as in the window
+            model->setDate(frame.date);
+            loadedDate = frame.date;
+            view->date = model->getDate();
+            view->camera = model->getStore().getPos(BODY_JWS);
+        }
+        view->currentBodyIndex = frame.target;
+        focusCurrentBody(frame.fov <= 0);
+        if (frame.fov > 0)
+            setFov(frame.fov);
+
+        std::chrono::steady_clock::time_point loaded = std::chrono::steady_clock::now();
+        renderHeadlessFrame();
+        char fileName[32];
+        snprintf(fileName, sizeof(fileName), "frame%05zu.bmp", i);
+        frameExporter.submit(outputPrefix + fileName);
+
+        std::chrono::steady_clock::time_point rendered = std::chrono::steady_clock::now();
+        loadSeconds += std::chrono::duration<double>(loaded - start).count();
+        renderSeconds += std::chrono::duration<double>(rendered - loaded).count();
     }
 
-    setModelDate(desiredDate);
+    // The last frames are still being read back and written
+    std::chrono::steady_clock::time_point drainStart = std::chrono::steady_clock::now();
+    size_t written = frameExporter.finish();
+    double drainSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - drainStart).count();
+
+    double totalSeconds = loadSeconds + renderSeconds + drainSeconds;
+    double stallSeconds = frameExporter.getStallSeconds();
+    std::cout << std::fixed << std::setprecision(2)
+              << "Rendered " << frames.size() << " frames of " << screenWidth << " x " << screenHeight
+              << " in " << totalSeconds << " s: " << frames.size() / totalSeconds << " frames/s" << std::endl
+              << "  render and readback " << renderSeconds - stallSeconds << " s ("
+              << frames.size() / (renderSeconds - stallSeconds) << " frames/s), date loads " << loadSeconds << " s, "
+              << "waiting for writers " << stallSeconds + drainSeconds << " s" << std::endl;
+
+    clearSharedMem();
+    headlessContext.release();
+    delete model;
+    model = NULL;
+    return (written == frames.size()) ? 0 : 1;
 }
 
-void setModelDate(std::string date) {
-    view->date = date;
-    model->setDate(view->date);
+bool readFrameSequence(const char *path, std::vector<HeadlessFrame> &frames) {
+    // One frame per line: yyyy-mm-dd target [fov], the target by catalog name and the FOV in degrees,
+    // left out or 0 to zoom to the target. Blank lines and lines from a # are skipped.
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open the frame sequence " << path << std::endl;
+        return false;
+    }
+    std::string text;
+    for (int lineNumber = 1; std::getline(file, text); lineNumber++) {
+        text = text.substr(0, text.find('#'));
+        std::istringstream line(text);
+        HeadlessFrame frame;
+        frame.fov = 0;
+        std::string targetName;
+        if (!(line >> frame.date))
+            continue;
+        line >> targetName;
+        if (!(line >> frame.fov) && !line.eof()) {
+            std::cerr << path << ":" << lineNumber << ": invalid FOV in " << text << std::endl;
+            return false;
+        }
 
-    focusCurrentBody(view->rezoomOnDateChange);
-}
\ No newline at end of file
+        CalendarDate calendarDate;
+        BodyId target = findBody(targetName.c_str());
+        if (!julian::parseCalendar(frame.date.c_str(), calendarDate)) {
+            std::cerr << path << ":" << lineNumber << ": invalid date " << frame.date << std::endl;
+            return false;
+        }
+        if (target >= (int)VIEWABLE_BODY_COUNT) {
+            std::cerr << path << ":" << lineNumber << ": unknown target " << targetName << std::endl;
+            return false;
+        }
+        frame.target = target;
+        frames.push_back(frame);
+    }
+    if (frames.empty()) {
+        std::cerr << "No frames in " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void renderHeadlessFrame() {
+    // displayCB without the HUD, which needs a GLUT window, leaving the frame in the framebuffer
+    cullBodies();
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    glPushMatrix();
+    generateModel();
+    glPopMatrix();
+}
@@ -0,0 +1,86 @@
+#ifndef BodyCatalog_h
+#define BodyCatalog_h
+
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * @brief Dense body identifiers, the index of a body in the catalog and in every per-body array.
+ * Viewable bodies come first in the order the target keys cycle through them.
+ *
+ */
+enum BodyId {
+    BODY_EARTH,
+    BODY_MOON,
+    BODY_SUN,
+    BODY_MERCURY,
+    BODY_VENUS,
+    BODY_MARS,
+    BODY_JUPITER,
+    BODY_SATURN,
+    BODY_URANUS,
+    BODY_NEPTUNE,
+    BODY_JWS,
+    BODY_COUNT
+};
+
+enum BodyMaterial {
+    MATERIAL_LIT,       // diffuse surface lit by the Sun
+    MATERIAL_EMISSIVE   // light source, full ambient
+};
+
+/**
+ * @brief Everything known about a body before any data is loaded
+ *
+ */
+struct BodyInfo {
+    const char *name;
+    long index;             // Horizons / NAIF id
+    const char *texture;    // image under the image directory, NULL if the body is not drawn
+    float color[3];
+    BodyMaterial material;
+};
+
+constexpr BodyInfo BODY_CATALOG[BODY_COUNT] = {
+    {"Earth",   399,  "earth.bmp",   {0.204f, 0.365f, 0.545f}, MATERIAL_LIT},
+    {"Moon",    301,  "moon.bmp",    {1, 0.961f, 0.925f},      MATERIAL_LIT},
+    {"Sun",     10,   "sun.bmp",     {1, 0.80f, 0.20f},        MATERIAL_EMISSIVE},
+    {"Mercury", 1,    "mercury.bmp", {0.894f, 0.788f, 0.6f},   MATERIAL_LIT},
+    {"Venus",   2,    "venus.bmp",   {0.773f, 0.447f, 0.133f}, MATERIAL_LIT},
+    {"Mars",    499,  "mars.bmp",    {0.91f, 0.396f, 0.227f},  MATERIAL_LIT},
+    {"Jupiter", 599,  "jupiter.bmp", {0.824f, 0.71f, 0.518f},  MATERIAL_LIT},
+    {"Saturn",  699,  "saturn.bmp",  {0.816f, 0.702f, 0.467f}, MATERIAL_LIT},
+    {"Uranus",  799,  "uranus.bmp",  {0.031f, 0.459f, 0.588f}, MATERIAL_LIT},
+    {"Neptune", 899,  "neptune.bmp", {0.424f, 0.561f, 0.89f},  MATERIAL_LIT},
+    {"JWS",     -170, NULL,          {1, 1, 1},                MATERIAL_LIT}
+};
+
+/**
+ * @brief Number of drawn bodies, they are the first ones of the catalog
+ *
+ */
+constexpr size_t countViewableBodies() {
+    size_t count = 0;
+    while (count < BODY_COUNT && BODY_CATALOG[count].texture != NULL)
+        count++;
+    return count;
+}
+
+constexpr size_t VIEWABLE_BODY_COUNT = countViewableBodies();
+
+/**
+ * @brief Catalog id of a body name, BODY_COUNT if unknown. For setup and user input, not per frame.
+ *
+ */
+inline BodyId findBody(const char *name) {
+    for (size_t id = 0; id < BODY_COUNT; id++) {
+        if (strcmp(BODY_CATALOG[id].name, name) == 0)
+            return (BodyId)id;
+    }
+    return BODY_COUNT;
+}
+
+// The enum and the catalog rows must stay in step
+static_assert(BODY_CATALOG[BODY_SUN].index == 10 && BODY_CATALOG[BODY_JWS].index == -170, "Body catalog out of order");
+
+#endif
@@ -0,0 +1,77 @@
+#include "bodyStore.hpp"
+
+//===============================================================================================================
+// BodyStore Class
+//...............................................................................................................
+// Constructor
+//...............................................................................................................
+BodyStore::BodyStore() {
+    this->count = 0;
+    this->resize(BODY_COUNT);
+    for (size_t id = 0; id < BODY_COUNT; id++)
+        this->material[id] = BODY_CATALOG[id].material;
+}
+
+//...............................................................................................................
+// Public Methods
+//...............................................................................................................
+void BodyStore::resize(size_t count) {
+    this->count = count;
+    for (std::vector<float> *column : {&this->x, &this->y, &this->z, &this->radius})
+        column->resize(count, 0);
+    this->posError.resize(count, -1);
+    this->texId.resize(count, 0);
+    this->material.resize(count, MATERIAL_LIT);
+}
+
+size_t BodyStore::size() {
+    return this->count;
+}
+
+void BodyStore::setPos(size_t id, glm::vec3 pos, float radius, float posError) {
+    this->x[id] = pos.x;
+    this->y[id] = pos.y;
+    this->z[id] = pos.z;
+    this->radius[id] = radius;
+    this->posError[id] = posError;
+}
+
+void BodyStore::setTexId(size_t id, unsigned int texId) {
+    this->texId[id] = texId;
+}
+
+void BodyStore::setMaterial(size_t id, BodyMaterial material) {
+    this->material[id] = material;
+}
+
+glm::vec3 BodyStore::getPos(size_t id) {
+    return glm::vec3(this->x[id], this->y[id], this->z[id]);
+}
+
+const float *BodyStore::getX() {
+    return this->x.data();
+}
+
+const float *BodyStore::getY() {
+    return this->y.data();
+}
+
+const float *BodyStore::getZ() {
+    return this->z.data();
+}
+
+const float *BodyStore::getRadius() {
+    return this->radius.data();
+}
+
+const float *BodyStore::getPosError() {
+    return this->posError.data();
+}
+
+const unsigned int *BodyStore::getTexId() {
+    return this->texId.data();
+}
+
+const unsigned char *BodyStore::getMaterial() {
+    return this->material.data();
+}
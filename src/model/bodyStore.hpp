@@ -0,0 +1,48 @@
+#ifndef BodyStore_h
+#define BodyStore_h
+
+#include <stddef.h>
+#include <vector>
+#include <glm/glm.hpp>
+#include "bodyCatalog.hpp"
+
+/**
+ * @brief Render side copy of every body, one contiguous array per attribute indexed by body id.
+ * The frame loop walks these arrays directly, with no name lookups or pointers to follow, and the store
+ * grows to any number of bodies past the catalog.
+ *
+ */
+class BodyStore {
+private:
+    size_t count;
+    std::vector<float> x, y, z;         // geocentric position (km)
+    std::vector<float> radius;          // km
+    std::vector<float> posError;        // km, -1 if unknown
+    std::vector<unsigned int> texId;    // GL texture, 0 if none
+    std::vector<unsigned char> material;
+
+public:
+    /**
+     * @brief Store of the catalog bodies with their catalog materials
+     *
+     */
+    BodyStore();
+
+    void resize(size_t count);
+    size_t size();
+
+    void setPos(size_t id, glm::vec3 pos, float radius, float posError);
+    void setTexId(size_t id, unsigned int texId);
+    void setMaterial(size_t id, BodyMaterial material);
+
+    glm::vec3 getPos(size_t id);
+    const float *getX();
+    const float *getY();
+    const float *getZ();
+    const float *getRadius();
+    const float *getPosError();
+    const unsigned int *getTexId();
+    const unsigned char *getMaterial();
+};
+
+#endif
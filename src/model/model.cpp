@@ -1,22 +1,17 @@
 #include "model.hpp"
+#include "nasaClient/julianDate.hpp"
 #include <iostream>
+#include <stdlib.h>
+#include <unistd.h>
 #include <bits/stdc++.h>
 
 //===============================================================================================================
 // Constants Definition
 //===============================================================================================================
-std::map<std::string, glm::vec3> body_info = {
-    {"Sun", glm::vec3(1, 0.80, 0.20)},
-    {"Mercury", glm::vec3(0.894, 0.788, 0.6)}, 
-    {"Venus", glm::vec3(0.773, 0.447, 0.133)},
-    {"Earth", glm::vec3(0.204, 0.365, 0.545)},
-    {"Moon", glm::vec3(1, 0.961, 0.925)},
-    {"Mars", glm::vec3(0.91, 0.396, 0.227)},
-    {"Jupiter", glm::vec3(0.824, 0.71, 0.518)},
-    {"Saturn", glm::vec3(0.816, 0.702, 0.467)},
-    {"Uranus", glm::vec3(0.031, 0.459, 0.588)},
-    {"Neptune", glm::vec3(0.424, 0.561, 0.89)},
-    {"JWS", glm::vec3(1, 1, 1)}};
+const double DEFAULT_PREFETCH_WINDOW = 365; // days either side of the requested date
+const char *SPK_KERNEL_PATH = "kernels/de440s.bsp";
+const double SPK_VELOCITY_STEP = 0.01;      // days either side of a date for velocities from the kernel
+const char *SMALL_BODIES_PATH = "data/MPCORB.DAT";
 
 //===============================================================================================================
 // Model Class
@@ -25,22 +20,70 @@ std::map<std::string, glm::vec3> body_info = {
 //...............................................................................................................
 Model::Model(const std::string date) {
     this->client = new NasaClient();
+
+    // Bodies in a local JPL kernel (SPACE_SPK_KERNEL, or the default path if present) are never fetched
+    const char *kernelPath = getenv("SPACE_SPK_KERNEL");
+    this->spk = NULL;
+    if (kernelPath != NULL || access(SPK_KERNEL_PATH, R_OK) == 0)
+        this->spk = new SpkEphemeris((kernelPath != NULL) ? kernelPath : SPK_KERNEL_PATH);
+    const char *smallBodiesPath = getenv("SPACE_SMALL_BODIES");
+    if (smallBodiesPath != NULL || access(SMALL_BODIES_PATH, R_OK) == 0)
+        this->smallBodies.load((smallBodiesPath != NULL) ? smallBodiesPath : SMALL_BODIES_PATH);
     this->date = date;
-    this->nbodys = 0;
-    for (auto const& pair : body_info) {
-        std::string name = pair.first;
-        this->bodys.insert({name, new Body(name, pair.second)});
-        Body *body = this->bodys[name];
-        this->client->getBodyData(*body, date);
-        this->nbodys++;
-    }    
-}
-
-// Model::~Model() {
-//     // for (auto const& pair : this->bodys) {
-//     //     delete pair.second;
-//     // }
-// }
+    this->jd = 0;
+    this->propagating = false;
+    this->backJd = 0;
+    this->prefetchWindow = DEFAULT_PREFETCH_WINDOW;
+    for (const BodyInfo &info : BODY_CATALOG) {
+        glm::vec3 color(info.color[0], info.color[1], info.color[2]);
+        this->bodys.push_back(new Body(info.name, info.index, color));
+        this->trajectories.push_back(new Trajectory());
+        this->backBodys.push_back(new Body(info.name, info.index, color));
+        this->backTrajectories.push_back(new Trajectory());
+        this->indices.push_back(info.index);
+    }
+    this->framePos.resize(3 * BODY_COUNT);
+    this->frameError.resize(BODY_COUNT);
+    this->frameDirectPos.resize(3 * BODY_COUNT);
+    this->frameValid.reset(new bool[BODY_COUNT]);
+    this->frameDirect.reset(new bool[BODY_COUNT]);
+
+    // Start from the analytic ephemeris, refined by the cached states closest to the date, and let the
+    // worker fetch the date in the background
+    CalendarDate calendarDate;
+    double jd = julian::parseCalendar(date.c_str(), calendarDate) ? julian::fromCalendar(calendarDate) : 0;
+    for (Body *body : this->bodys) {
+        EphemerisRecord state, sunState;
+        if (this->client->getNearestCachedState(*body, jd, state, sunState))
+            this->kepler.setState(state.index, state.jd, state.pos, state.vel, sunState.pos, sunState.vel);
+    }
+    this->backKepler = this->kepler;
+    this->setJulianDate(jd);
+
+    this->loading = false;
+    this->ready = false;
+    this->stopping = false;
+    this->worker = std::thread(&Model::runWorker, this);
+    this->requestDate(date);
+}
+
+Model::~Model() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->changed.notify_all();
+    this->worker.join();
+
+    for (size_t id = 0; id < BODY_COUNT; id++) {
+        delete this->bodys[id];
+        delete this->backBodys[id];
+        delete this->trajectories[id];
+        delete this->backTrajectories[id];
+    }
+    delete this->client;
+    delete this->spk;
+}
 
 //...............................................................................................................
 // Public Methods
@@ -62,19 +105,316 @@ Model::Model(const std::string date) {
 //     glBindTexture(GL_TEXTURE_2D, 0);
 // }
 
+void Model::setPrefetchWindow(double days) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->prefetchWindow = days;
+}
+
 void Model::setDate(std::string date) {
-    for (auto const& pair : this->bodys) {
-        this->client->getBodyData(*pair.second, date);
+    if (!this->requestDate(date))
+        return;
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (true) {
+        // An older result may have to be swapped in before the worker takes this request
+        this->changed.wait(lock, [this] { return this->ready; });
+        bool latest = this->requestedDate.empty();
+        lock.unlock();
+        this->update();
+        if (latest)
+            return;
+        lock.lock();
+    }
+}
+
+bool Model::requestDate(std::string date) {
+    CalendarDate calendarDate;
+    if (!julian::parseCalendar(date.c_str(), calendarDate))
+        return false;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->requestedDate = date;
+        this->loadingDate = date;
+    }
+    this->changed.notify_all();
+
+    // Show the date at once from what is already in memory
+    this->setJulianDate(julian::fromCalendar(calendarDate));
+    return true;
+}
+
+bool Model::update() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (!this->ready)
+        return false;
+
+    // The worker is idle until the next request, so the back state can be read and its trajectories swapped
+    for (size_t id = 0; id < BODY_COUNT; id++) {
+        Body *body = this->bodys[id];
+        Body *back = this->backBodys[id];
+        if (back->hasState())
+            body->updateState(back->getStatePos(), back->getStateVel(), back->getRadius(), back->getDataDate(), back->getPosError());
+        else
+            body->updateData(back->getPos(), back->getRadius(), back->getDataDate(), back->getPosError());
+        this->store.setPos(id, body->getPos(), body->getRadius(), body->getPosError());
+        std::swap(this->trajectories[id], this->backTrajectories[id]);
     }
+    this->kepler = this->backKepler;
+    this->propagator = this->backPropagator;
+    this->date = this->backDate;
+    this->jd = this->backJd;
+    this->placeSmallBodies(this->jd);
+    this->ready = false;
+    if (this->requestedDate.empty() && !this->loading)
+        this->loadingDate.clear();
+    this->changed.notify_all();
+    return true;
+}
+
+bool Model::isLoading() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return !this->loadingDate.empty();
+}
+
+std::string Model::getLoadingDate() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->loadingDate;
+}
+
+bool Model::setJulianDate(double jd) {
+    // Runs every animation frame, so it works on the id-indexed arrays and preallocated buffers only
+    size_t n = BODY_COUNT;
+    double *pos = this->framePos.data();
+    double *error = this->frameError.data();
+    double *directPos = this->frameDirectPos.data();
+    bool *valid = this->frameValid.get();
+    bool *direct = this->frameDirect.get();
+    interpolateTrajectories(this->trajectories.data(), n, jd, pos, error, valid);
+
+    std::fill(direct, direct + n, false);
+    if (this->propagating) {
+        this->propagator.propagate(jd);
+        this->propagator.getPositions(this->indices.data(), n, directPos, direct);
+    } else if (this->spk != NULL) {
+        this->spk->getPositions(this->indices.data(), n, &jd, 1, directPos, direct);
+    }
+
+    char date[48];
+    julian::formatCalendar(julian::toCalendar(jd), date, sizeof(date));
+    bool covered = true;
+    for (size_t id = 0; id < n; id++) {
+        Body *body = this->bodys[id];
+        float radius = this->trajectories[id]->getRadius();
+        long index = this->indices[id];
+        if (radius == 0)
+            radius = (body->getRadius() > 0) ? body->getRadius() : this->kepler.getRadius(index);
+        if (direct[id]) {
+            // Kernel positions are exact, propagated ones have no error estimate
+            std::copy(&directPos[3 * id], &directPos[3 * id] + 3, &pos[3 * id]);
+            error[id] = this->propagating ? -1 : 0;
+        } else if (!valid[id]) {
+            // Outside the trajectory, fall back to the analytic ephemeris with its last measured error
+            covered = false;
+            if (!this->kepler.getPos(index, jd, &pos[3 * id]))
+                continue;
+            KeplerError analyticError = this->kepler.getError(index);
+            error[id] = (analyticError.samples > 0) ? analyticError.max : -1;
+        }
+        glm::vec3 bodyPos(pos[3 * id], pos[3 * id + 1], pos[3 * id + 2]);
+        body->updateData(bodyPos, radius, date, error[id]);
+        this->store.setPos(id, bodyPos, radius, error[id]);
+    }
+
     this->date = date;
+    this->jd = jd;
+    this->placeSmallBodies(jd);
+    return covered || this->propagating;
+}
+
+bool Model::setPropagation(bool enabled) {
+    if (enabled && this->propagator.size() == 0)
+        return false;
+    this->propagating = enabled;
+    this->setJulianDate(this->jd);
+    return true;
+}
+
+bool Model::isPropagating() {
+    return this->propagating;
+}
+
+bool Model::perturbBody(BodyId id, glm::dvec3 deltaV) {
+    double dv[3] = {deltaV.x, deltaV.y, deltaV.z};
+    if (id >= BODY_COUNT || !this->setPropagation(true))
+        return false;
+    return this->propagator.kick(this->indices[id], dv);
 }
 
 std::string Model::getDate() {
     return this->date;
 }
 
+double Model::getJulianDate() {
+    return this->jd;
+}
+
+Body * Model::getBody(BodyId id) {
+    return (id < BODY_COUNT) ? this->bodys[id] : NULL;
+}
+
 Body * Model::getBody(std::string name) {
-    return this->bodys[name];
+    return this->getBody(findBody(name.c_str()));
+}
+
+BodyStore &Model::getStore() {
+    return this->store;
+}
+
+SmallBodies &Model::getSmallBodies() {
+    return this->smallBodies;
+}
+
+KeplerError Model::getAnalyticError(BodyId id) {
+    return this->kepler.getError(this->indices[id]);
+}
+
+//...............................................................................................................
+// Private Methods
+//...............................................................................................................
+void Model::runWorker() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (true) {
+        this->changed.wait(lock, [this] { return this->stopping || (!this->requestedDate.empty() && !this->ready); });
+        if (this->stopping)
+            return;
+
+        std::string date = this->requestedDate;
+        double window = this->prefetchWindow;
+        this->requestedDate.clear();
+        this->loading = true;
+        lock.unlock();
+        this->loadDate(date, window);
+        lock.lock();
+        this->loading = false;
+
+        // A newer request supersedes this one, keep the fetched trajectories and go again
+        if (this->requestedDate.empty())
+            this->ready = true;
+        this->changed.notify_all();
+    }
+}
+
+void Model::loadDate(std::string date, double window) {
+    CalendarDate calendarDate;
+    julian::parseCalendar(date.c_str(), calendarDate);
+    double jd = julian::fromCalendar(calendarDate);
+
+    // Bodies covered by the kernel are evaluated locally, the others go through Horizons
+    bool local[BODY_COUNT];
+    for (size_t id = 0; id < BODY_COUNT; id++) {
+        Body *body = this->backBodys[id];
+        double pos[3], vel[3];
+        local[id] = this->getSpkState(body->getIndex(), jd, pos, vel);
+        if (!local[id])
+            continue;
+        float radius = (body->getRadius() > 0) ? body->getRadius() : this->backKepler.getRadius(body->getIndex());
+        body->updateState(glm::dvec3(pos[0], pos[1], pos[2]), glm::dvec3(vel[0], vel[1], vel[2]), radius, date, 0);
+    }
+
+    // Fetch a new window only for bodies whose trajectory does not cover the date
+    if (window > 0) {
+        std::vector<Body *> bodies;
+        std::vector<Trajectory *> trajectories;
+        for (size_t id = 0; id < BODY_COUNT; id++) {
+            Trajectory *trajectory = this->backTrajectories[id];
+            if (local[id])
+                continue;
+
+            // The front trajectories are only swapped while the worker is idle, so they can be read here
+            Trajectory *front = this->trajectories[id];
+            if (!trajectory->contains(jd) && front->contains(jd))
+                *trajectory = *front;
+            if (!trajectory->contains(jd)) {
+                bodies.push_back(this->backBodys[id]);
+                trajectories.push_back(trajectory);
+            }
+        }
+        if (!bodies.empty())
+            this->client->getBodiesWindow(bodies, trajectories, jd - window, jd + window);
+    }
+
+    // Bodies outside their trajectory (e.g. outside the Horizons coverage of a spacecraft) are fetched for the date alone
+    std::vector<Body *> remaining;
+    for (size_t id = 0; id < BODY_COUNT; id++) {
+        Trajectory *trajectory = this->backTrajectories[id];
+        double pos[3], vel[3];
+        if (local[id])
+            continue;
+        if (trajectory->getState(jd, pos, vel))
+            this->backBodys[id]->updateState(glm::dvec3(pos[0], pos[1], pos[2]), glm::dvec3(vel[0], vel[1], vel[2]), trajectory->getRadius(), date);
+        else
+            remaining.push_back(this->backBodys[id]);
+    }
+    if (!remaining.empty())
+        this->client->getBodiesData(remaining, date);
+    this->refineKepler(jd);
+
+    // Bodies Horizons could not provide keep an analytic position
+    for (Body *body : this->backBodys) {
+        double pos[3];
+        if (body->getDataDate() == date || !this->backKepler.getPos(body->getIndex(), jd, pos))
+            continue;
+        float radius = (body->getRadius() > 0) ? body->getRadius() : this->backKepler.getRadius(body->getIndex());
+        KeplerError error = this->backKepler.getError(body->getIndex());
+        body->updateData(glm::vec3(pos[0], pos[1], pos[2]), radius, date, (error.samples > 0) ? error.max : -1);
+    }
+
+    // Snapshot of every state vector at the date for the propagator
+    this->backPropagator.clear();
+    for (Body *body : this->backBodys) {
+        if (!body->hasState())
+            continue;
+        glm::dvec3 pos = body->getStatePos();
+        glm::dvec3 vel = body->getStateVel();
+        double statePos[3] = {pos.x, pos.y, pos.z};
+        double stateVel[3] = {vel.x, vel.y, vel.z};
+        this->backPropagator.addBody(body->getIndex(), jd, statePos, stateVel);
+    }
+    this->backDate = date;
+    this->backJd = jd;
+}
+
+void Model::refineKepler(double jd) {
+    // Osculating elements from the fetched states at the date, then the error over each whole trajectory
+    double sunPos[3], sunVel[3];
+    if (!this->backTrajectories[BODY_SUN]->getState(jd, sunPos, sunVel) && !this->getSpkState(this->indices[BODY_SUN], jd, sunPos, sunVel))
+        return;
+    for (size_t id = 0; id < BODY_COUNT; id++) {
+        double pos[3], vel[3];
+        if (this->backTrajectories[id]->getState(jd, pos, vel))
+            this->backKepler.setState(this->indices[id], jd, pos, vel, sunPos, sunVel);
+    }
+    for (size_t id = 0; id < BODY_COUNT; id++)
+        this->backKepler.measureError(this->indices[id], *this->backTrajectories[id]);
+}
+
+bool Model::getSpkState(long index, double jd, double pos[3], double vel[3]) {
+    // The kernel gives positions only, the velocity is a central difference
+    double before[3], after[3];
+    if (this->spk == NULL || !this->spk->getPos(index, jd, pos) ||
+        !this->spk->getPos(index, jd - SPK_VELOCITY_STEP, before) || !this->spk->getPos(index, jd + SPK_VELOCITY_STEP, after))
+        return false;
+    for (int k = 0; k < 3; k++)
+        vel[k] = (after[k] - before[k]) / (2 * SPK_VELOCITY_STEP * 86400);
+    return true;
+}
+
+void Model::placeSmallBodies(double jd) {
+    // Around the Sun as drawn, whichever source placed it
+    if (this->smallBodies.size() == 0)
+        return;
+    glm::vec3 sun = this->store.getPos(BODY_SUN);
+    double sunPos[3] = {sun.x, sun.y, sun.z};
+    this->smallBodies.update(jd, sunPos);
 }
 
 //===============================================================================================================
@@ -2,22 +2,170 @@
 #define Model_h
 
 #include "nasaClient/nasaClient.hpp"
+#include "nasaClient/trajectory.hpp"
+#include "nasaClient/keplerEphemeris.hpp"
+#include "nasaClient/spkEphemeris.hpp"
+#include "nasaClient/nBodyPropagator.hpp"
+#include "nasaClient/smallBodies.hpp"
+#include "bodyCatalog.hpp"
+#include "bodyStore.hpp"
 #include <string>
-#include <map>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 class Model {
 private:
+    // Front state, read and animated by the render thread
     std::string date;
-    std::map<std::string, Body *> bodys;
-    long nbodys;
+    double jd;
+    std::vector<Body *> bodys;                  // by BodyId
+    std::vector<Trajectory *> trajectories;
+    std::vector<long> indices;                  // Horizons index of each body
+    BodyStore store;
+    KeplerEphemeris kepler;     // positions of bodies outside their trajectory
+    NBodyPropagator propagator; // system integrated from the state vectors of the last loaded date
+    bool propagating;           // place bodies by the propagator instead of the ephemerides
+    SmallBodies smallBodies;    // asteroid point cloud, empty without an orbit file
+
+    // Buffers of setJulianDate, so animation frames do not allocate
+    std::vector<double> framePos;
+    std::vector<double> frameError;
+    std::vector<double> frameDirectPos;
+    std::unique_ptr<bool[]> frameValid;
+    std::unique_ptr<bool[]> frameDirect;
+
+    // Back state, filled by the worker thread and swapped into the front state by update()
+    std::string backDate;
+    double backJd;
+    std::vector<Body *> backBodys;
+    std::vector<Trajectory *> backTrajectories;
+    KeplerEphemeris backKepler;
+    NBodyPropagator backPropagator;
     NasaClient *client;
+    SpkEphemeris *spk;          // local JPL kernel, NULL if none; read-only so both threads use it
+    double prefetchWindow;
+
+    /**
+     * @brief Worker thread running every date change, the only user of the client
+     * 
+     */
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::string requestedDate;  // next date for the worker, empty if none
+    std::string loadingDate;    // latest requested date, empty once it reached the front state
+    bool loading;               // worker is filling the back state
+    bool ready;                 // back state is complete and waits for update()
+    bool stopping;
+
+    void runWorker();
+    void loadDate(std::string date, double window);
+    void refineKepler(double jd);
+    bool getSpkState(long index, double jd, double pos[3], double vel[3]);
+    void placeSmallBodies(double jd);
 public:
     Model(const std::string date);
-    // ~Model();
+    ~Model();
+
+    /**
+     * @brief Set how many days either side of a requested date are fetched per body.
+     * Dates inside a fetched window are looked up in memory, 0 fetches only the requested date.
+     * 
+     */
+    void setPrefetchWindow(double days);
 
     // void generateModel(RenderManager &rm);
+
+    /**
+     * @brief Move every body to a date and wait for it, blocking on any network I/O
+     * 
+     */
     void setDate(std::string date);
+
+    /**
+     * @brief Ask the worker thread to load a date and return at once. A newer request replaces one
+     * that has not started, the result shows up in the front state on the first update() after it completes.
+     * Until then bodies outside their trajectory are placed by the analytic ephemeris.
+     * 
+     * @return false if the date is not a valid calendar date
+     */
+    bool requestDate(std::string date);
+
+    /**
+     * @brief Swap a completed date change into the front state, called by the render thread once per frame
+     * 
+     * @return true if the bodies changed
+     */
+    bool update();
+
+    /**
+     * @brief Check if a requested date has not reached the front state yet
+     * 
+     */
+    bool isLoading();
+
+    /**
+     * @brief Date being loaded, empty if none
+     * 
+     */
+    std::string getLoadingDate();
+
+    /**
+     * @brief Move every body to a fractional Julian date by interpolating the prefetched trajectories,
+     * without any fetches. Bodies covered by the SPK kernel are evaluated from it instead (or integrated while
+     * propagating), and bodies whose trajectory does not cover the date are placed by the analytic ephemeris.
+     * 
+     * @return true if every body was covered by the kernel or its trajectory
+     */
+    bool setJulianDate(double jd);
+
+    /**
+     * @brief Place the bodies by integrating their mutual gravity from the state vectors of the last loaded
+     * date instead of reading the ephemerides, until a new date is loaded or it is turned off.
+     * Bodies without a state vector keep their ephemeris position.
+     * 
+     * @return false if no state vectors were loaded yet
+     */
+    bool setPropagation(bool enabled);
+    bool isPropagating();
+
+    /**
+     * @brief Add a velocity change (km/s) to a body at the current date and follow the perturbed system
+     * with the propagator
+     * 
+     * @return false if the body has no state vector
+     */
+    bool perturbBody(BodyId id, glm::dvec3 deltaV);
     std::string getDate();
+    double getJulianDate();
+    Body *getBody(BodyId id);
+
+    /**
+     * @brief Body by catalog name, a linear search for setup code
+     * 
+     */
     Body *getBody(std::string name);
+
+    /**
+     * @brief Dense arrays of the bodies for the render loop, updated with every date change
+     * 
+     */
+    BodyStore &getStore();
+
+    /**
+     * @brief Asteroids of the orbit file (SPACE_SMALL_BODIES, or the default path if present),
+     * placed at the current date around the Sun of the store
+     * 
+     */
+    SmallBodies &getSmallBodies();
+
+    /**
+     * @brief Error of the analytic ephemeris against the last Horizons trajectory of a body
+     * 
+     */
+    KeplerError getAnalyticError(BodyId id);
 };
 #endif 
\ No newline at end of file
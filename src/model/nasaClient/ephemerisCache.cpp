@@ -0,0 +1,189 @@
+#include "ephemerisCache.hpp"
+
+#include <iostream>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using std::endl;
+using std::cerr;
+
+//===============================================================================================================
+// Constants Definition
+//===============================================================================================================
+static const char CACHE_MAGIC[8] = {'E', 'P', 'H', 'C', 'A', 'C', 'H', 'E'};
+static const uint32_t CACHE_VERSION = 2;
+static const uint64_t INITIAL_CAPACITY = 4096;
+
+//===============================================================================================================
+// EphemerisCache Class
+//...............................................................................................................
+// Constructor and Destructor
+//...............................................................................................................
+EphemerisCache::EphemerisCache(std::string path) {
+    this->path = path;
+    this->fd = -1;
+    this->mappedSize = 0;
+    this->header = NULL;
+    this->records = NULL;
+    if (!this->open())
+        cerr << "Ephemeris cache disabled for " << path << endl;
+}
+
+EphemerisCache::~EphemerisCache() {
+    this->close();
+}
+
+//...............................................................................................................
+// Public Methods
+//...............................................................................................................
+bool EphemerisCache::isOpen() {
+    return this->header != NULL;
+}
+
+size_t EphemerisCache::size() {
+    return this->isOpen() ? this->header->count : 0;
+}
+
+const EphemerisRecord *EphemerisCache::find(long index, double jd) {
+    if (!this->isOpen())
+        return NULL;
+    auto slot = this->slots.find({index, jd});
+    if (slot == this->slots.end())
+        return NULL;
+    return &this->records[slot->second];
+}
+
+const EphemerisRecord *EphemerisCache::findNearest(long index, double jd) {
+    const EphemerisRecord *nearest = NULL;
+    for (uint64_t i = 0; i < this->size(); i++) {
+        const EphemerisRecord *record = &this->records[i];
+        if (record->index == index && (nearest == NULL || fabs(record->jd - jd) < fabs(nearest->jd - jd)))
+            nearest = record;
+    }
+    return nearest;
+}
+
+void EphemerisCache::insert(const EphemerisRecord &record) {
+    if (!this->isOpen())
+        return;
+
+    auto slot = this->slots.find({record.index, record.jd});
+    if (slot != this->slots.end()) {
+        this->records[slot->second] = record;
+        return;
+    }
+
+    if (this->header->count == this->header->capacity && !this->map(this->header->capacity * 2))
+        return;
+
+    uint64_t count = this->header->count;
+    this->records[count] = record;
+    this->header->count = count + 1;
+    this->slots.insert({{record.index, record.jd}, count});
+}
+
+//...............................................................................................................
+// Private Methods
+//...............................................................................................................
+size_t EphemerisCache::KeyHash::operator()(const Key &key) const {
+    uint64_t bits;
+    memcpy(&bits, &key.jd, sizeof(bits));
+    return std::hash<uint64_t>()(bits ^ ((uint64_t)key.index * 0x9E3779B97F4A7C15ULL));
+}
+
+bool EphemerisCache::open() {
+    size_t slash = this->path.find_last_of('/');
+    if (slash != std::string::npos)
+        mkdir(this->path.substr(0, slash).c_str(), 0755);
+
+    this->fd = ::open(this->path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (this->fd < 0)
+        return false;
+
+    // The mapping, its capacity and the key index are private to this process, so a second process
+    // appending or growing the same file would write past its own mapping. Held until close().
+    if (flock(this->fd, LOCK_EX | LOCK_NB) != 0) {
+        cerr << "Ephemeris cache " << this->path << " is in use by another process" << endl;
+        this->close();
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(this->fd, &info) != 0) {
+        this->close();
+        return false;
+    }
+
+    // A new, truncated or older format file is started over
+    if ((size_t)info.st_size < sizeof(Header))
+        return this->reset();
+
+    Header existing;
+    if (pread(this->fd, &existing, sizeof(existing), 0) != sizeof(existing) ||
+        memcmp(existing.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        existing.version != CACHE_VERSION ||
+        existing.recordSize != sizeof(EphemerisRecord) ||
+        existing.count > existing.capacity ||
+        (size_t)info.st_size < sizeof(Header) + existing.capacity * sizeof(EphemerisRecord))
+        return this->reset();
+
+    if (!this->map(existing.capacity))
+        return false;
+
+    this->slots.reserve(this->header->count);
+    for (uint64_t i = 0; i < this->header->count; i++)
+        this->slots[{this->records[i].index, this->records[i].jd}] = i;
+    return true;
+}
+
+bool EphemerisCache::map(uint64_t capacity) {
+    size_t size = sizeof(Header) + capacity * sizeof(EphemerisRecord);
+    if (this->header != NULL) {
+        munmap(this->header, this->mappedSize);
+        this->header = NULL;
+        this->records = NULL;
+    }
+    if (ftruncate(this->fd, size) != 0) {
+        this->close();
+        return false;
+    }
+
+    void *mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+    if (mapped == MAP_FAILED) {
+        this->close();
+        return false;
+    }
+    this->mappedSize = size;
+    this->header = (Header *)mapped;
+    this->records = (EphemerisRecord *)((char *)mapped + sizeof(Header));
+    this->header->capacity = capacity;
+    return true;
+}
+
+void EphemerisCache::close() {
+    if (this->header != NULL)
+        munmap(this->header, this->mappedSize);
+    if (this->fd >= 0)
+        ::close(this->fd);
+    this->header = NULL;
+    this->records = NULL;
+    this->fd = -1;
+    this->mappedSize = 0;
+    this->slots.clear();
+}
+
+bool EphemerisCache::reset() {
+    this->slots.clear();
+    if (ftruncate(this->fd, 0) != 0 || !this->map(INITIAL_CAPACITY))
+        return false;
+    memcpy(this->header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    this->header->version = CACHE_VERSION;
+    this->header->recordSize = sizeof(EphemerisRecord);
+    this->header->count = 0;
+    return true;
+}
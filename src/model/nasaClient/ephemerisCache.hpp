@@ -0,0 +1,92 @@
+#ifndef EphemerisCache_h
+#define EphemerisCache_h
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief Parsed Horizons data of one body at one epoch, stored as a fixed size record
+ *
+ */
+struct EphemerisRecord {
+    int64_t index;      // Horizons body index
+    double jd;          // Julian date of the sample
+    double pos[3];      // position (km)
+    double vel[3];      // velocity (km/s)
+    double radius;      // radius (km)
+};
+
+/**
+ * @brief Disk backed cache of Horizons body data keyed by body index and Julian date.
+ * The cache file is a header followed by fixed size records and is memory-mapped when opened,
+ * so a lookup costs a hash probe and at most a page fault. One process at a time owns the file through an
+ * exclusive lock, any other one opening it runs without the cache.
+ *
+ */
+class EphemerisCache {
+private:
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        uint64_t count;
+        uint64_t capacity;
+    };
+
+    struct Key {
+        int64_t index;
+        double jd;
+        bool operator==(const Key &other) const { return index == other.index && jd == other.jd; }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key &key) const;
+    };
+
+    std::string path;
+    int fd;
+    size_t mappedSize;
+    Header *header;
+    EphemerisRecord *records;
+    std::unordered_map<Key, uint64_t, KeyHash> slots;
+
+    bool open();
+    bool map(uint64_t capacity);
+    void close();
+    bool reset();
+
+public:
+    /**
+     * @brief Open (or create) the cache file at the given path.
+     * The cache is disabled, and every lookup misses, if the file cannot be mapped.
+     *
+     */
+    EphemerisCache(std::string path);
+    ~EphemerisCache();
+
+    bool isOpen();
+    size_t size();
+
+    /**
+     * @brief Find the record of a body at a Julian date
+     *
+     * @return pointer into the mapped file, valid until the next insert, or NULL on a miss
+     */
+    const EphemerisRecord *find(long index, double jd);
+
+    /**
+     * @brief Find the record of a body closest in time to a Julian date, scanning every record
+     *
+     * @return pointer into the mapped file, valid until the next insert, or NULL if the body has no record
+     */
+    const EphemerisRecord *findNearest(long index, double jd);
+
+    /**
+     * @brief Add or replace the record for record.index at record.jd
+     *
+     */
+    void insert(const EphemerisRecord &record);
+};
+
+#endif
@@ -0,0 +1,427 @@
+#include "horizonsParser.hpp"
+
+#include <charconv>
+#include <string.h>
+#include <string_view>
+
+using std::string_view;
+
+//===============================================================================================================
+// Constants Definition
+//===============================================================================================================
+// Horizons lines are under 100 characters, longer ones are only kept up to this length
+static const size_t MAX_LINE = 4096;
+
+//===============================================================================================================
+// Helper Function Definition
+//===============================================================================================================
+static bool parseNumber(const char *begin, const char *end, double &value);
+static bool parseTagged(string_view line, string_view tag, double &value);
+static int hexValue(char c);
+static size_t encodeUtf8(unsigned int code, char *out);
+
+//===============================================================================================================
+// HorizonsParser Class
+//...............................................................................................................
+// Constructor
+//...............................................................................................................
+HorizonsParser::HorizonsParser() {
+    this->reset();
+}
+
+//...............................................................................................................
+// Public Methods
+//...............................................................................................................
+void HorizonsParser::reset() {
+    this->state = HEADER;
+    this->row = HorizonsRow();
+    this->rowHasPos = false;
+    this->primaryRadius = 0;
+    this->secondaryRadius = 0;
+    this->hasPrimaryRadius = false;
+    this->hasSecondaryRadius = false;
+    this->rows.clear();
+}
+
+void HorizonsParser::parseLine(const char *begin, const char *end) {
+    if (end > begin && end[-1] == '\r')
+        end--;
+    switch (this->state) {
+    case HEADER:
+        this->parseHeaderLine(begin, end);
+        break;
+    case TABLE:
+        this->parseTableLine(begin, end);
+        break;
+    case DONE:
+        break;
+    }
+}
+
+void HorizonsParser::parseText(const char *begin, const char *end) {
+    const char *line = begin;
+    while (line < end && this->state != DONE) {
+        const char *newline = (const char *)memchr(line, '\n', end - line);
+        const char *lineEnd = (newline != NULL) ? newline : end;
+        this->parseLine(line, lineEnd);
+        line = lineEnd + 1;
+    }
+}
+
+bool HorizonsParser::isComplete() {
+    return this->state == DONE;
+}
+
+const std::vector<HorizonsRow> &HorizonsParser::getRows() {
+    return this->rows;
+}
+
+float HorizonsParser::getRadius() {
+    // Same preference as before: the first "radius" entry, then "Radius (km)" if that one is 0
+    if (this->primaryRadius != 0)
+        return this->primaryRadius;
+    return this->secondaryRadius;
+}
+
+//...............................................................................................................
+// Private Methods
+//...............................................................................................................
+void HorizonsParser::parseHeaderLine(const char *begin, const char *end) {
+    string_view line(begin, end - begin);
+    if (line.compare(0, 5, "$$SOE") == 0) {
+        this->state = TABLE;
+        return;
+    }
+
+    if (!this->hasPrimaryRadius) {
+        size_t tag = line.find("radius");
+        size_t equals = (tag != string_view::npos) ? line.find("= ", tag) : string_view::npos;
+        if (equals != string_view::npos) {
+            this->hasPrimaryRadius = true;
+            parseNumber(begin + equals + 2, end, this->primaryRadius);
+        }
+    }
+    if (!this->hasSecondaryRadius) {
+        size_t tag = line.find("Radius (km) ");
+        size_t equals = (tag != string_view::npos) ? line.find('=', tag) : string_view::npos;
+        if (equals != string_view::npos) {
+            this->hasSecondaryRadius = true;
+            parseNumber(begin + equals + 1, end, this->secondaryRadius);
+        }
+    }
+}
+
+void HorizonsParser::parseTableLine(const char *begin, const char *end) {
+    string_view line(begin, end - begin);
+
+    // Rows are "<jd> = A.D. <date> TDB", " X = .. Y = .. Z = ..", " VX= .. VY= .. VZ= ..", " LT= .. RG= .. RR= .."
+    if (line.find("VX=") != string_view::npos) {
+        if (this->rowHasPos &&
+            parseTagged(line, "VX=", this->row.vel[0]) &&
+            parseTagged(line, "VY=", this->row.vel[1]) &&
+            parseTagged(line, "VZ=", this->row.vel[2])) {
+            this->rows.push_back(this->row);
+        }
+        this->rowHasPos = false;
+    } else if (line.find("X =") != string_view::npos) {
+        this->rowHasPos = parseTagged(line, "X =", this->row.pos[0]) &&
+                          parseTagged(line, "Y =", this->row.pos[1]) &&
+                          parseTagged(line, "Z =", this->row.pos[2]);
+        this->row.vel[0] = this->row.vel[1] = this->row.vel[2] = 0;
+    } else if (line.compare(0, 5, "$$EOE") == 0 || line.find(" = A.D.") != string_view::npos || line.find(" = B.C.") != string_view::npos) {
+        // Tables without velocities have no VX line to complete the previous row
+        if (this->rowHasPos)
+            this->rows.push_back(this->row);
+        this->rowHasPos = false;
+        if (line[0] == '$')
+            this->state = DONE;
+        else
+            parseNumber(begin, end, this->row.jd);
+    }
+}
+
+//===============================================================================================================
+// HorizonsStream Class
+//...............................................................................................................
+// Constructor
+//...............................................................................................................
+HorizonsStream::HorizonsStream() {
+    this->line.reserve(MAX_LINE);
+    this->reset();
+}
+
+//...............................................................................................................
+// Public Methods
+//...............................................................................................................
+void HorizonsStream::reset() {
+    this->state = SEEK_KEY;
+    this->keySize = 0;
+    this->code = 0;
+    this->codeDigits = 0;
+    this->failed = false;
+    this->line.clear();
+    this->parser.reset();
+}
+
+size_t HorizonsStream::write(const char *data, size_t size) {
+    const char *c = data;
+    const char *end = data + size;
+    while (c < end) {
+        switch (this->state) {
+        case SEEK_KEY:
+            if (*c == '"') {
+                this->keySize = 0;
+                this->state = KEY;
+            }
+            c++;
+            break;
+        case KEY:
+            if (*c == '"') {
+                this->state = AFTER_KEY;
+            } else {
+                if (*c == '\\')
+                    this->state = KEY_ESCAPE;
+                // Only the first bytes matter, a longer key never equals "result"
+                if (this->keySize < sizeof(this->key))
+                    this->key[this->keySize] = *c;
+                this->keySize++;
+            }
+            c++;
+            break;
+        case KEY_ESCAPE:
+            this->state = KEY;
+            c++;
+            break;
+        case AFTER_KEY:
+            if (*c == ' ' || *c == '\t' || *c == '\r' || *c == '\n') {
+                c++;
+            } else if (*c == ':') {
+                this->state = VALUE;
+                c++;
+            } else {
+                // A string followed by anything but ':' was an array element, not a key
+                this->state = SEEK_KEY;
+            }
+            break;
+        case VALUE:
+            if (*c == ' ' || *c == '\t' || *c == '\r' || *c == '\n') {
+                c++;
+            } else if (*c == '"') {
+                bool isResult = this->keySize == 6 && memcmp(this->key, "result", 6) == 0;
+                this->state = isResult ? RESULT : SKIP_STRING;
+                c++;
+            } else {
+                this->state = SEEK_KEY;
+            }
+            break;
+        case SKIP_STRING:
+            if (*c == '\\')
+                this->state = SKIP_ESCAPE;
+            else if (*c == '"')
+                this->state = SEEK_KEY;
+            c++;
+            break;
+        case SKIP_ESCAPE:
+            this->state = SKIP_STRING;
+            c++;
+            break;
+        case RESULT: {
+            // Copy the run of plain characters up to the next escape or the closing quote at once
+            const char *run = c;
+            while (run < end && *run != '\\' && *run != '"')
+                run++;
+            this->append(c, run);
+            c = run;
+            if (c == end)
+                break;
+            if (*c == '"') {
+                this->endLine();
+                this->state = END;
+            } else {
+                this->state = RESULT_ESCAPE;
+            }
+            c++;
+            break;
+        }
+        case RESULT_ESCAPE: {
+            char escaped = 0;
+            switch (*c) {
+            case 'n': this->endLine(); break;
+            case 't': escaped = '\t'; break;
+            case 'r': escaped = '\r'; break;
+            case 'b': escaped = '\b'; break;
+            case 'f': escaped = '\f'; break;
+            case 'u': this->code = 0; this->codeDigits = 0; break;
+            default: escaped = *c; break;   // \" \\ \/
+            }
+            if (escaped != 0)
+                this->append(&escaped, &escaped + 1);
+            this->state = (*c == 'u') ? RESULT_UNICODE : RESULT;
+            c++;
+            break;
+        }
+        case RESULT_UNICODE: {
+            int digit = hexValue(*c);
+            if (digit < 0) {
+                this->failed = true;
+                this->state = END;
+                break;
+            }
+            this->code = (this->code << 4) | digit;
+            if (++this->codeDigits == 4) {
+                if (this->code == '\n')
+                    this->endLine();
+                else
+                    this->appendCode(this->code);
+                this->state = RESULT;
+            }
+            c++;
+            break;
+        }
+        case END:
+            return size;
+        }
+    }
+    return size;
+}
+
+bool HorizonsStream::isComplete() {
+    return this->state == END && !this->failed && this->parser.isComplete();
+}
+
+HorizonsParser &HorizonsStream::getParser() {
+    return this->parser;
+}
+
+//...............................................................................................................
+// Private Methods
+//...............................................................................................................
+void HorizonsStream::append(const char *begin, const char *end) {
+    size_t room = MAX_LINE - this->line.size();
+    size_t size = end - begin;
+    this->line.append(begin, (size < room) ? size : room);
+}
+
+void HorizonsStream::appendCode(unsigned int code) {
+    char utf8[3];
+    size_t size = encodeUtf8(code, utf8);
+    this->append(utf8, utf8 + size);
+}
+
+void HorizonsStream::endLine() {
+    this->parser.parseLine(this->line.data(), this->line.data() + this->line.size());
+    this->line.clear();
+}
+
+//===============================================================================================================
+// Functions
+//===============================================================================================================
+bool unescapeHorizonsResult(char *response, size_t size, char **result, size_t *resultSize) {
+    string_view text(response, size);
+    size_t key = text.find("\"result\"");
+    if (key == string_view::npos)
+        return false;
+
+    size_t i = key + 8;
+    while (i < size && (response[i] == ' ' || response[i] == '\t' || response[i] == '\r' || response[i] == '\n' || response[i] == ':'))
+        i++;
+    if (i >= size || response[i] != '"')
+        return false;
+    i++;
+
+    // Unescaped text is never longer than the escaped text, so it is written over it
+    char *out = response + i;
+    char *start = out;
+    while (i < size && response[i] != '"') {
+        char c = response[i++];
+        if (c != '\\') {
+            *out++ = c;
+            continue;
+        }
+        if (i >= size)
+            return false;
+        char escaped = response[i++];
+        switch (escaped) {
+        case 'n': *out++ = '\n'; break;
+        case 't': *out++ = '\t'; break;
+        case 'r': *out++ = '\r'; break;
+        case 'b': *out++ = '\b'; break;
+        case 'f': *out++ = '\f'; break;
+        case 'u': {
+            if (i + 4 > size)
+                return false;
+            unsigned int code = 0;
+            for (int k = 0; k < 4; k++) {
+                int digit = hexValue(response[i++]);
+                if (digit < 0)
+                    return false;
+                code = (code << 4) | digit;
+            }
+            out += encodeUtf8(code, out);
+            break;
+        }
+        default: *out++ = escaped; break;   // \" \\ \/
+        }
+    }
+    if (i >= size)
+        return false;
+
+    *out = '\0';
+    *result = start;
+    *resultSize = out - start;
+    return true;
+}
+
+bool parseHorizonsResponse(char *response, size_t size, HorizonsParser &parser) {
+    char *result;
+    size_t resultSize;
+    if (!unescapeHorizonsResult(response, size, &result, &resultSize))
+        return false;
+    parser.parseText(result, result + resultSize);
+    return parser.isComplete();
+}
+
+//===============================================================================================================
+// Helper Functions
+//===============================================================================================================
+static bool parseNumber(const char *begin, const char *end, double &value) {
+    while (begin < end && (*begin == ' ' || *begin == '+'))
+        begin++;
+    std::from_chars_result parsed = std::from_chars(begin, end, value);
+    return parsed.ec == std::errc();
+}
+
+static bool parseTagged(string_view line, string_view tag, double &value) {
+    size_t index = line.find(tag);
+    if (index == string_view::npos)
+        return false;
+    const char *number = line.data() + index + tag.size();
+    return parseNumber(number, line.data() + line.size(), value);
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+static size_t encodeUtf8(unsigned int code, char *out) {
+    // Horizons text is ASCII, other code points only need to survive as UTF-8
+    if (code < 0x80) {
+        out[0] = (char)code;
+        return 1;
+    }
+    if (code < 0x800) {
+        out[0] = (char)(0xC0 | (code >> 6));
+        out[1] = (char)(0x80 | (code & 0x3F));
+        return 2;
+    }
+    out[0] = (char)(0xE0 | (code >> 12));
+    out[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+    out[2] = (char)(0x80 | (code & 0x3F));
+    return 3;
+}
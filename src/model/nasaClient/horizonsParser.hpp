@@ -0,0 +1,160 @@
+#ifndef HorizonsParser_h
+#define HorizonsParser_h
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+/**
+ * @brief One row of a Horizons vector table
+ *
+ */
+struct HorizonsRow {
+    double jd;          // Julian date (TDB)
+    double pos[3];      // position (km)
+    double vel[3];      // velocity (km/s)
+};
+
+/**
+ * @brief Single pass scanner for the text of a Horizons VECTORS result.
+ * The text is fed one line at a time, the physical data header is searched for the body radius and every
+ * row between $$SOE and $$EOE is parsed with std::from_chars. Rows are kept in a vector that is reused
+ * between responses, so a warmed up parser does not allocate.
+ *
+ */
+class HorizonsParser {
+private:
+    enum State {
+        HEADER,
+        TABLE,
+        DONE
+    };
+
+    State state;
+    HorizonsRow row;
+    bool rowHasPos;
+    double primaryRadius;
+    double secondaryRadius;
+    bool hasPrimaryRadius;
+    bool hasSecondaryRadius;
+    std::vector<HorizonsRow> rows;
+
+    void parseHeaderLine(const char *begin, const char *end);
+    void parseTableLine(const char *begin, const char *end);
+
+public:
+    HorizonsParser();
+
+    /**
+     * @brief Forget the previous response, keeping the row storage
+     *
+     */
+    void reset();
+
+    /**
+     * @brief Scan one line of the result text, without its line break
+     *
+     */
+    void parseLine(const char *begin, const char *end);
+
+    /**
+     * @brief Scan a block of result text made of whole lines
+     *
+     */
+    void parseText(const char *begin, const char *end);
+
+    /**
+     * @brief Check if the vector table was found and read up to $$EOE
+     *
+     */
+    bool isComplete();
+
+    const std::vector<HorizonsRow> &getRows();
+
+    /**
+     * @brief Radius from the physical data header (km), 0 if none was found
+     *
+     */
+    float getRadius();
+};
+
+/**
+ * @brief Incremental tokenizer for a Horizons JSON response, fed with the chunks curl receives.
+ * The "result" string is unescaped as it arrives and handed to a HorizonsParser one line at a time, so a
+ * response is parsed while it downloads and only the line being assembled is buffered. The line buffer and
+ * the parser rows keep their storage across reset(), so a stream can be reused from one request to the next.
+ *
+ */
+class HorizonsStream {
+private:
+    enum State {
+        SEEK_KEY,           // between tokens, waiting for the next object key
+        KEY,                // inside a key string
+        KEY_ESCAPE,
+        AFTER_KEY,          // waiting for the ':' after a key
+        VALUE,              // waiting for the value after ':'
+        SKIP_STRING,        // inside a string value other than "result"
+        SKIP_ESCAPE,
+        RESULT,             // inside the "result" string
+        RESULT_ESCAPE,
+        RESULT_UNICODE,
+        END
+    };
+
+    State state;
+    char key[8];
+    size_t keySize;
+    unsigned int code;
+    int codeDigits;
+    bool failed;
+    std::string line;
+    HorizonsParser parser;
+
+    void append(const char *begin, const char *end);
+    void appendCode(unsigned int code);
+    void endLine();
+
+public:
+    HorizonsStream();
+
+    /**
+     * @brief Start a new response, keeping the line buffer and row storage
+     *
+     */
+    void reset();
+
+    /**
+     * @brief Consume the next chunk of the response body
+     *
+     * @return number of bytes consumed, always size so it can be returned from a curl write callback
+     */
+    size_t write(const char *data, size_t size);
+
+    /**
+     * @brief Check if the whole result string was read and held a complete vector table
+     *
+     */
+    bool isComplete();
+
+    HorizonsParser &getParser();
+};
+
+/**
+ * @brief Locate the "result" string of a Horizons JSON response and unescape it in place
+ *
+ * @param response response body, modified in place
+ * @param size response size in bytes
+ * @param result set to the unescaped result text
+ * @param resultSize set to the unescaped result length
+ * @return false if the response has no result string
+ */
+bool unescapeHorizonsResult(char *response, size_t size, char **result, size_t *resultSize);
+
+/**
+ * @brief Unescape a Horizons JSON response in place and scan its result text
+ *
+ * @return false if the response has no complete vector table
+ */
+bool parseHorizonsResponse(char *response, size_t size, HorizonsParser &parser);
+
+#endif
@@ -0,0 +1,154 @@
+#include "httpFixtures.hpp"
+
+#include <iostream>
+#include <stdlib.h>
+#include <math.h>
+#include <sys/stat.h>
+
+using std::endl;
+using std::cerr;
+
+//===============================================================================================================
+// Helper Function Definition
+//===============================================================================================================
+static uint64_t hashUrl(const std::string &url);
+
+//===============================================================================================================
+// ReplayLatency Class
+//...............................................................................................................
+// Constructor
+//...............................................................................................................
+ReplayLatency::ReplayLatency() {
+    this->distribution = NONE;
+    this->a = 0;
+    this->b = 0;
+    this->seed(0);
+}
+
+//...............................................................................................................
+// Public Methods
+//...............................................................................................................
+bool ReplayLatency::parse(std::string description) {
+    if (description.empty()) {
+        this->distribution = NONE;
+        return true;
+    }
+
+    char name[16];
+    double a = 0;
+    double b = 0;
+    int fields = sscanf(description.c_str(), "%15[a-z]:%lf:%lf", name, &a, &b);
+    std::string kind = (fields >= 1) ? name : "";
+    if (kind == "fixed" && fields == 2)
+        this->distribution = FIXED;
+    else if (kind == "uniform" && fields == 3 && a <= b)
+        this->distribution = UNIFORM;
+    else if (kind == "normal" && fields == 3)
+        this->distribution = NORMAL;
+    else if (kind == "lognormal" && fields == 3 && a > 0)
+        this->distribution = LOGNORMAL;
+    else
+        return false;
+    this->a = a;
+    this->b = b;
+    return true;
+}
+
+void ReplayLatency::seed(uint32_t seed) {
+    this->generator.seed(seed);
+}
+
+double ReplayLatency::sample() {
+    switch (this->distribution) {
+    case FIXED:
+        return this->a;
+    case UNIFORM:
+        return std::uniform_real_distribution<double>(this->a, this->b)(this->generator);
+    case NORMAL: {
+        double latency = std::normal_distribution<double>(this->a, this->b)(this->generator);
+        return (latency > 0) ? latency : 0;
+    }
+    case LOGNORMAL:
+        return std::lognormal_distribution<double>(log(this->a), this->b)(this->generator);
+    case NONE:
+        break;
+    }
+    return 0;
+}
+
+//===============================================================================================================
+// HttpFixtures Class
+//...............................................................................................................
+// Constructor
+//...............................................................................................................
+HttpFixtures::HttpFixtures(std::string directory) {
+    this->directory = directory;
+    if (!this->directory.empty() && this->directory.back() != '/')
+        this->directory += '/';
+}
+
+//...............................................................................................................
+// Public Methods
+//...............................................................................................................
+std::string HttpFixtures::getPath(const std::string &url) {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.json", (unsigned long long)hashUrl(url));
+    return this->directory + name;
+}
+
+FILE *HttpFixtures::beginRecording(const std::string &url) {
+    mkdir(this->directory.c_str(), 0755);
+    std::string path = this->getPath(url) + ".part";
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == NULL)
+        cerr << "Unable to record to " << path << endl;
+    return file;
+}
+
+void HttpFixtures::endRecording(FILE *file, const std::string &url, bool keep) {
+    std::string path = this->getPath(url);
+    std::string part = path + ".part";
+    bool written = !ferror(file);
+    written = (fclose(file) == 0) && written;
+    if (!keep || !written || rename(part.c_str(), path.c_str()) != 0) {
+        remove(part.c_str());
+        return;
+    }
+
+    std::string indexPath = this->directory + "index.txt";
+    FILE *index = fopen(indexPath.c_str(), "a");
+    if (index != NULL) {
+        fprintf(index, "%s %s\n", path.substr(this->directory.size()).c_str(), url.c_str());
+        fclose(index);
+    }
+}
+
+bool HttpFixtures::load(const std::string &url, std::vector<char> &body) {
+    std::string path = this->getPath(url);
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == NULL) {
+        cerr << "No recorded response for " << url << endl;
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    body.resize(size > 0 ? size : 0);
+    bool read = fread(body.data(), 1, body.size(), file) == body.size();
+    fclose(file);
+    return read;
+}
+
+//===============================================================================================================
+// Helper Functions
+//===============================================================================================================
+static uint64_t hashUrl(const std::string &url) {
+    // 64 bit FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : url) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
@@ -0,0 +1,93 @@
+#ifndef HttpFixtures_h
+#define HttpFixtures_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Simulated network latency of a replayed request, in milliseconds
+ *
+ */
+class ReplayLatency {
+private:
+    enum Distribution {
+        NONE,
+        FIXED,          // fixed:<ms>
+        UNIFORM,        // uniform:<min ms>:<max ms>
+        NORMAL,         // normal:<mean ms>:<stddev ms>, clamped at 0
+        LOGNORMAL       // lognormal:<median ms>:<sigma>, long tailed like real round trips
+    };
+
+    Distribution distribution;
+    double a;
+    double b;
+    std::mt19937 generator;
+
+public:
+    ReplayLatency();
+
+    /**
+     * @brief Read a distribution such as "uniform:50:400", an empty string means no latency
+     *
+     * @return false if the description is not understood
+     */
+    bool parse(std::string description);
+
+    /**
+     * @brief Reseed the generator so a replay run sees the same latencies every time
+     *
+     */
+    void seed(uint32_t seed);
+
+    /**
+     * @brief Draw the latency of the next request (ms)
+     *
+     */
+    double sample();
+};
+
+/**
+ * @brief Directory of recorded HTTP responses, one file per request URL.
+ * Files are named after a 64 bit FNV-1a hash of the URL and index.txt lists the URL of each file,
+ * so a fixture set can be inspected, pruned or copied to a machine without network access.
+ *
+ */
+class HttpFixtures {
+private:
+    std::string directory;
+
+public:
+    HttpFixtures(std::string directory);
+
+    /**
+     * @brief Path of the response file recorded for a URL
+     *
+     */
+    std::string getPath(const std::string &url);
+
+    /**
+     * @brief Open a temporary file for the response body of a URL
+     *
+     * @return NULL if the file could not be created
+     */
+    FILE *beginRecording(const std::string &url);
+
+    /**
+     * @brief Close a recording, keeping it only if the transfer succeeded
+     *
+     */
+    void endRecording(FILE *file, const std::string &url, bool keep);
+
+    /**
+     * @brief Read the recorded response of a URL
+     *
+     * @param body filled with the response, its storage is reused
+     * @return false if no response was recorded for the URL
+     */
+    bool load(const std::string &url, std::vector<char> &body);
+};
+
+#endif
@@ -0,0 +1,111 @@
+#include "julianDate.hpp"
+
+#include <stdio.h>
+
+//===============================================================================================================
+// Reference Table
+// Outputs of https://ssd-api.jpl.nasa.gov/jd_cal.api checked at compile time
+//...............................................................................................................
+namespace {
+
+struct Reference {
+    const char *calendar;
+    double jd;
+};
+
+constexpr Reference references[] = {
+    {"2000-01-01_12:00", 2451545.0},        // J2000.0
+    {"2023-03-21", 2460024.5},              // model start date
+    {"2023-03-07", 2460010.5},
+    {"1970-01-01", 2440587.5},              // unix epoch
+    {"1858-11-17", 2400000.5},              // MJD 0
+    {"1957-10-04_19:26:24", 2436116.31},    // Meeus example 7.a
+    {"1600-01-01", 2305447.5},
+    {"1582-10-15", 2299160.5},              // first Gregorian day
+    {"1582-10-04", 2299159.5},              // last Julian day
+    {"0333-01-27_12:00", 1842713.0},        // Meeus example 7.b (Julian calendar)
+    {"-1000-07-12_12:00", 1356001.0},
+    {"-4712-01-01_12:00", 0.0},             // JD 0
+    {"2024-02-29", 2460369.5},              // Gregorian leap day
+    {"2000-02-29", 2451603.5},              // Gregorian leap century
+    {"1500-02-29", 2268991.5},              // Julian leap century
+};
+
+// Texts parseCalendar must reject
+constexpr const char *invalidDates[] = {
+    "2023-02-29",                           // not a leap year
+    "2023-02-31",
+    "2023-04-31",
+    "1900-02-29",                           // Gregorian century, not a leap year
+    "1582-10-05",                           // days dropped by the Gregorian switch
+    "1582-10-10",
+    "1582-10-14",
+    "2023-13-01",
+    "2023-00-10",
+    "2023-01-00",
+};
+
+constexpr double absolute(double value) {
+    return value < 0 ? -value : value;
+}
+
+constexpr bool checkToJulian() {
+    for (const Reference &reference : references) {
+        CalendarDate date;
+        if (!julian::parseCalendar(reference.calendar, date))
+            return false;
+        if (absolute(julian::fromCalendar(date) - reference.jd) > 1e-6)
+            return false;
+    }
+    return true;
+}
+
+constexpr bool checkRoundTrip() {
+    for (const Reference &reference : references) {
+        CalendarDate parsed;
+        julian::parseCalendar(reference.calendar, parsed);
+        CalendarDate date = julian::toCalendar(reference.jd);
+        if (date.year != parsed.year || date.month != parsed.month || date.day != parsed.day ||
+            date.hour != parsed.hour || date.minute != parsed.minute || absolute(date.second - parsed.second) > 1e-3)
+            return false;
+    }
+    return true;
+}
+
+constexpr bool checkRejected() {
+    for (const char *text : invalidDates) {
+        CalendarDate date;
+        if (julian::parseCalendar(text, date))
+            return false;
+    }
+    return true;
+}
+
+static_assert(checkToJulian(), "calendar to Julian date conversion does not match jd_cal");
+static_assert(checkRoundTrip(), "Julian date to calendar conversion does not match jd_cal");
+static_assert(checkRejected(), "impossible calendar dates are accepted");
+
+}
+
+//===============================================================================================================
+// Formatting
+//...............................................................................................................
+size_t julian::formatJulian(double jd, char *buffer, size_t size) {
+    int len = snprintf(buffer, size, "%.9f", jd);
+    if (len <= 0 || (size_t)len >= size)
+        return 0;
+
+    // Trim trailing zeros but keep one decimal, like the jd_cal output
+    while (len > 0 && buffer[len - 1] == '0' && buffer[len - 2] != '.')
+        len--;
+    buffer[len] = '\0';
+    return (size_t)len;
+}
+
+size_t julian::formatCalendar(const CalendarDate &date, char *buffer, size_t size) {
+    int len = snprintf(buffer, size, "%04ld-%02d-%02d %02d:%02d:%06.3f",
+                       date.year, date.month, date.day, date.hour, date.minute, date.second);
+    if (len <= 0 || (size_t)len >= size)
+        return 0;
+    return (size_t)len;
+}
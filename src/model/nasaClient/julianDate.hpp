@@ -0,0 +1,195 @@
+#ifndef JulianDate_h
+#define JulianDate_h
+
+#include <stddef.h>
+
+/**
+ * @brief Calendar date broken into its fields. Dates before 1582-10-15 are on the Julian
+ * calendar and dates from then on are on the Gregorian calendar, matching the jd_cal API.
+ *
+ */
+struct CalendarDate {
+    long year = 0;
+    int month = 1;
+    int day = 1;
+    int hour = 0;
+    int minute = 0;
+    double second = 0;
+};
+
+//===============================================================================================================
+// Calendar <-> Julian Date Conversion
+// Algorithms: Meeus, Astronomical Algorithms (2nd ed.), chapter 7
+//...............................................................................................................
+namespace julian {
+
+constexpr double GREGORIAN_START_JD = 2299160.5;   // 1582-10-15 00:00
+
+constexpr long floorDiv(long a, long b) {
+    return (a % b != 0 && ((a < 0) != (b < 0))) ? a / b - 1 : a / b;
+}
+
+constexpr long floorToLong(double value) {
+    long truncated = (long)value;
+    return (value < truncated) ? truncated - 1 : truncated;
+}
+
+constexpr bool isGregorian(long year, int month, int day) {
+    if (year != 1582)
+        return year > 1582;
+    if (month != 10)
+        return month > 10;
+    return day >= 15;
+}
+
+/**
+ * @brief Days in a month, by the Julian leap rule before the 1582 switch and the Gregorian one after
+ *
+ */
+constexpr int daysInMonth(long year, int month) {
+    const int days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (month != 2)
+        return days[month - 1];
+    bool leap = (year - floorDiv(year, 4) * 4) == 0;
+    if (year > 1582 && (year - floorDiv(year, 100) * 100) == 0)
+        leap = (year - floorDiv(year, 400) * 400) == 0;
+    return leap ? 29 : 28;
+}
+
+/**
+ * @brief Julian day number of the calendar day starting at the preceding midnight (JD of 00:00 + 0.5)
+ *
+ */
+constexpr long dayNumber(long year, int month, int day) {
+    long y = year;
+    long m = month;
+    if (m <= 2) {
+        y -= 1;
+        m += 12;
+    }
+    long b = 0;
+    if (isGregorian(year, month, day)) {
+        long a = floorDiv(y, 100);
+        b = 2 - a + floorDiv(a, 4);
+    }
+    return floorDiv(1461 * (y + 4716), 4) + (306001 * (m + 1)) / 10000 + day + b - 1524;
+}
+
+constexpr double fromCalendar(const CalendarDate &date) {
+    double dayFraction = (date.hour + (date.minute + date.second / 60.0) / 60.0) / 24.0;
+    return (double)dayNumber(date.year, date.month, date.day) - 0.5 + dayFraction;
+}
+
+constexpr CalendarDate toCalendar(double jd) {
+    long z = floorToLong(jd + 0.5);
+    double fraction = jd + 0.5 - (double)z;
+    long a = z;
+    if (z >= 2299161) {
+        long alpha = floorToLong((z - 1867216.25) / 36524.25);
+        a = z + 1 + alpha - floorDiv(alpha, 4);
+    }
+    long b = a + 1524;
+    long c = floorToLong((b - 122.1) / 365.25);
+    long d = floorToLong(365.25 * c);
+    long e = (long)((b - d) * 10000 / 306001);
+
+    CalendarDate date;
+    date.day = (int)(b - d - (306001 * e) / 10000);
+    date.month = (int)((e < 14) ? e - 1 : e - 13);
+    date.year = (date.month > 2) ? c - 4716 : c - 4715;
+
+    // Round to the millisecond so 0.5 day does not print as 11:59:59.999
+    long millis = floorToLong(fraction * 86400000.0 + 0.5);
+    if (millis >= 86400000)
+        millis = 86400000 - 1;
+    date.hour = (int)(millis / 3600000);
+    date.minute = (int)((millis / 60000) % 60);
+    date.second = (millis % 60000) / 1000.0;
+    return date;
+}
+
+/**
+ * @brief Parse "yyyy-mm-dd", optionally followed by "_hh:mm[:ss[.sss]]" or " hh:mm[:ss[.sss]]".
+ *
+ * @return false if the text is not a valid date
+ */
+constexpr bool parseCalendar(const char *text, CalendarDate &date) {
+    const char *p = text;
+    auto readInt = [&p](long &value, int maxDigits) {
+        int digits = 0;
+        value = 0;
+        while (*p >= '0' && *p <= '9' && digits < maxDigits) {
+            value = value * 10 + (*p - '0');
+            p++;
+            digits++;
+        }
+        return digits > 0;
+    };
+
+    bool negative = false;
+    if (*p == '-') {
+        negative = true;
+        p++;
+    }
+    long year = 0, month = 0, day = 0, hour = 0, minute = 0;
+    if (!readInt(year, 6) || *p++ != '-' || !readInt(month, 2) || *p++ != '-' || !readInt(day, 2))
+        return false;
+    long signedYear = negative ? -year : year;
+    if (month < 1 || month > 12 || day < 1 || day > daysInMonth(signedYear, (int)month))
+        return false;
+    if (signedYear == 1582 && month == 10 && day > 4 && day < 15)
+        return false;   // dropped by the switch to the Gregorian calendar
+
+    double second = 0;
+    if (*p == '_' || *p == ' ' || *p == 'T') {
+        p++;
+        if (!readInt(hour, 2) || *p++ != ':' || !readInt(minute, 2))
+            return false;
+        if (*p == ':') {
+            p++;
+            long whole = 0;
+            if (!readInt(whole, 2))
+                return false;
+            second = (double)whole;
+            if (*p == '.') {
+                p++;
+                double scale = 0.1;
+                while (*p >= '0' && *p <= '9') {
+                    second += (*p - '0') * scale;
+                    scale /= 10;
+                    p++;
+                }
+            }
+        }
+        if (hour > 23 || minute > 59 || second >= 61)
+            return false;
+    }
+    if (*p != '\0')
+        return false;
+
+    date.year = signedYear;
+    date.month = (int)month;
+    date.day = (int)day;
+    date.hour = (int)hour;
+    date.minute = (int)minute;
+    date.second = second;
+    return true;
+}
+
+/**
+ * @brief Write the Julian date as it is used in Horizons queries (e.g. "2460024.5")
+ *
+ * @return number of characters written, excluding the terminating null
+ */
+size_t formatJulian(double jd, char *buffer, size_t size);
+
+/**
+ * @brief Write the calendar date as "yyyy-mm-dd hh:mm:ss.sss"
+ *
+ * @return number of characters written, excluding the terminating null
+ */
+size_t formatCalendar(const CalendarDate &date, char *buffer, size_t size);
+
+} // namespace julian
+
+#endif
@@ -0,0 +1,353 @@
+#include "keplerEphemeris.hpp"
+
+#include <math.h>
+
+//===============================================================================================================
+// Constants Definition
+//===============================================================================================================
+static const double AU = 149597870.7;                   // km
+static const double J2000 = 2451545.0;
+static const double DAYS_PER_CENTURY = 36525.0;
+static const double DEG = M_PI / 180.0;
+static const double GM_SUN = 1.32712440018e11;          // km^3/s^2
+static const double GM_EARTH_MOON = 403503.235;         // km^3/s^2
+static const double MOON_MASS_FRACTION = 0.0121505856;  // Moon / (Earth + Moon), offset of the geocentre from the barycentre
+static const double L2_DISTANCE_RATIO = 0.01004;        // (GM_EARTH_MOON / (3 GM_SUN))^(1/3), L2 distance from the Earth over the Sun-Earth distance
+
+/**
+ * @brief Standish table 1 row: a (au), e, I, L, long. perihelion, long. ascending node (deg) at J2000 and their rates per century
+ *
+ */
+struct PlanetElements {
+    long index;
+    double radius;
+    double a, e, i, L, varpi, node;
+    double aRate, eRate, iRate, LRate, varpiRate, nodeRate;
+};
+
+static const PlanetElements PLANETS[] = {
+    {1,   2439.7,  0.38709927, 0.20563593,  7.00497902, 252.25032350,  77.45779628,  48.33076593,
+                   0.00000037, 0.00001906, -0.00594749, 149472.67411175, 0.16047689, -0.12534081},
+    {2,   6051.8,  0.72333566, 0.00677672,  3.39467605, 181.97909950, 131.60246718,  76.67984255,
+                   0.00000390, -0.00004107, -0.00078890, 58517.81538729, 0.00268329, -0.27769418},
+    {399, 6371.0,  1.00000261, 0.01671123, -0.00001531, 100.46457166, 102.93768193,   0.0,
+                   0.00000562, -0.00004392, -0.01294668, 35999.37244981, 0.32327364,  0.0},
+    {499, 3389.5,  1.52371034, 0.09339410,  1.84969142,  -4.55343205, -23.94362959,  49.55953891,
+                   0.00001847, 0.00007882, -0.00813131, 19140.30268499, 0.44441088, -0.29257343},
+    {599, 69911.0, 5.20288700, 0.04838624,  1.30439695,  34.39644051,  14.72847983, 100.47390909,
+                   -0.00011607, -0.00013253, -0.00183714, 3034.74612775, 0.21252668, 0.20469106},
+    {699, 58232.0, 9.53667594, 0.05386179,  2.48599187,  49.95424423,  92.59887831, 113.66242448,
+                   -0.00125060, -0.00050991, 0.00193609, 1222.49362201, -0.41897216, -0.28867794},
+    {799, 25362.0, 19.18916464, 0.04725744, 0.77263783, 313.23810451, 170.95427630,  74.01692503,
+                   -0.00196176, -0.00004397, -0.00242939, 428.48202785, 0.40805281, 0.04240589},
+    {899, 24622.0, 30.06992276, 0.00859048, 1.77004347, -55.12002969,  44.96476227, 131.78422574,
+                   0.00026291, 0.00005105, 0.00035372, 218.45945325, -0.32241464, -0.00508664}
+};
+
+//===============================================================================================================
+// Helper Function Definition
+//===============================================================================================================
+static double solveKepler(double m, double e);
+static bool orbitFromState(const double r[3], const double v[3], double mu, double &a, double &e, double p[3], double q[3], double &m0, double &n);
+
+//===============================================================================================================
+// KeplerEphemeris Class
+//...............................................................................................................
+// Constructor
+//...............................................................................................................
+KeplerEphemeris::KeplerEphemeris() {
+    Entry entry = {};
+    entry.error = {0, 0, 0};
+
+    // Sun and telescope, placed from the Earth's orbit
+    entry.index = 10;
+    entry.kind = SUN;
+    entry.radius = 695700.0;
+    this->entries.push_back(entry);
+
+    entry.index = -170;
+    entry.kind = L2;
+    entry.radius = 0;
+    entry.osculatingSpan = 30;
+    this->entries.push_back(entry);
+
+    // Planets, the Earth row holds the Earth-Moon barycentre
+    for (const PlanetElements &planet : PLANETS) {
+        entry.index = planet.index;
+        entry.kind = (planet.index == 399) ? EARTH : HELIOCENTRIC;
+        entry.radius = planet.radius;
+        entry.osculatingSpan = 5 * 365.25;
+        entry.mean = {J2000, planet.a * AU, planet.e, planet.i, planet.L, planet.varpi, planet.node,
+                      planet.aRate * AU / DAYS_PER_CENTURY, planet.eRate / DAYS_PER_CENTURY, planet.iRate / DAYS_PER_CENTURY,
+                      planet.LRate / DAYS_PER_CENTURY, planet.varpiRate / DAYS_PER_CENTURY, planet.nodeRate / DAYS_PER_CENTURY};
+        this->entries.push_back(entry);
+    }
+
+    // Moon mean elements at 1999-12-31 0h (node 125.1228, perigee arg. 318.0634, mean anomaly 115.3654 deg),
+    // rates reduced by the general precession (1.397 deg/century) to stay in the J2000 ecliptic frame.
+    // The solar perturbations (evection, variation) are left out, osculating elements only hold for days.
+    const double PRECESSION = 1.3970 / DAYS_PER_CENTURY;
+    entry.index = 301;
+    entry.kind = GEOCENTRIC;
+    entry.radius = 1737.4;
+    entry.osculatingSpan = 2;
+    entry.mean = {2451543.5, 384400.0, 0.054900, 5.1454, 198.5516, 83.1862, 125.1228,
+                  0, 0, 0, 13.1763964649 - PRECESSION, 0.1114035140 - PRECESSION, -0.0529538083 - PRECESSION};
+    this->entries.push_back(entry);
+
+    this->earthSlot = this->slotOf(399);
+    this->moonSlot = this->slotOf(301);
+}
+
+//...............................................................................................................
+// Public Methods
+//...............................................................................................................
+bool KeplerEphemeris::hasBody(long index) {
+    return this->slotOf(index) >= 0;
+}
+
+double KeplerEphemeris::getRadius(long index) {
+    long slot = this->slotOf(index);
+    return (slot >= 0) ? this->entries[slot].radius : 0;
+}
+
+bool KeplerEphemeris::setState(long index, double jd, const double pos[3], const double vel[3], const double sunPos[3], const double sunVel[3]) {
+    long slot = this->slotOf(index);
+    if (slot < 0)
+        return false;
+
+    // The Sun's geocentric state is the Earth's heliocentric state reversed, both refine the Earth's orbit
+    Entry *entry = &this->entries[slot];
+    double r[3], v[3];
+    double mu = GM_SUN;
+    for (int c = 0; c < 3; c++) {
+        switch (entry->kind) {
+        case SUN:
+        case EARTH:
+            r[c] = -sunPos[c];
+            v[c] = -sunVel[c];
+            break;
+        case GEOCENTRIC:
+            r[c] = pos[c];
+            v[c] = vel[c];
+            mu = GM_EARTH_MOON;
+            break;
+        case HELIOCENTRIC:
+        case L2:
+            r[c] = pos[c] - sunPos[c];
+            v[c] = vel[c] - sunVel[c];
+            break;
+        }
+    }
+    if (entry->kind == SUN)
+        entry = &this->entries[this->earthSlot];
+
+    Orbit &orbit = entry->osculating;
+    if (!orbitFromState(r, v, mu, orbit.a, orbit.e, orbit.p, orbit.q, orbit.m0, orbit.n))
+        return false;
+    orbit.epoch = jd;
+    entry->hasOsculating = true;
+    return true;
+}
+
+bool KeplerEphemeris::getPos(long index, double jd, double pos[3]) {
+    long slot = this->slotOf(index);
+    if (slot < 0)
+        return false;
+    double earth[3];
+    this->earthPosition(jd, earth);
+    this->bodyPosition(this->entries[slot], jd, earth, pos);
+    return true;
+}
+
+void KeplerEphemeris::getPositions(const long *indices, size_t n, double jd, double *pos, bool *valid) {
+    double earth[3];
+    this->earthPosition(jd, earth);
+    for (size_t b = 0; b < n; b++) {
+        long slot = this->slotOf(indices[b]);
+        valid[b] = slot >= 0;
+        if (valid[b])
+            this->bodyPosition(this->entries[slot], jd, earth, &pos[3 * b]);
+        else
+            pos[3 * b] = pos[3 * b + 1] = pos[3 * b + 2] = 0;
+    }
+}
+
+void KeplerEphemeris::measureError(long index, Trajectory &trajectory) {
+    long slot = this->slotOf(index);
+    if (slot < 0)
+        return;
+
+    KeplerError error = {0, 0, 0};
+    double sum = 0;
+    for (size_t i = 0; i < trajectory.size(); i++) {
+        double jd = trajectory.getSampleDate(i);
+        double truth[3], model[3];
+        trajectory.getPos(jd, truth);
+        this->getPos(index, jd, model);
+        double dx = model[0] - truth[0];
+        double dy = model[1] - truth[1];
+        double dz = model[2] - truth[2];
+        double d2 = dx * dx + dy * dy + dz * dz;
+        sum += d2;
+        if (d2 > error.max)
+            error.max = d2;
+        error.samples++;
+    }
+    if (error.samples > 0) {
+        error.rms = sqrt(sum / error.samples);
+        error.max = sqrt(error.max);
+    }
+    this->entries[slot].error = error;
+}
+
+KeplerError KeplerEphemeris::getError(long index) {
+    long slot = this->slotOf(index);
+    if (slot < 0)
+        return {0, 0, 0};
+    return this->entries[slot].error;
+}
+
+//...............................................................................................................
+// Private Methods
+//...............................................................................................................
+long KeplerEphemeris::slotOf(long index) {
+    for (size_t slot = 0; slot < this->entries.size(); slot++) {
+        if (this->entries[slot].index == index)
+            return slot;
+    }
+    return -1;
+}
+
+bool KeplerEphemeris::orbitPosition(Entry &entry, double jd, double pos[3]) {
+    // Osculating elements near their epoch, the mean elements further away
+    bool osculating = entry.hasOsculating && fabs(jd - entry.osculating.epoch) <= entry.osculatingSpan;
+    double a, e, m;
+    double p[3], q[3];
+    if (osculating) {
+        const Orbit &orbit = entry.osculating;
+        a = orbit.a;
+        e = orbit.e;
+        m = orbit.m0 + orbit.n * (jd - orbit.epoch);
+        for (int c = 0; c < 3; c++) {
+            p[c] = orbit.p[c];
+            q[c] = orbit.q[c];
+        }
+    } else {
+        const MeanElements &mean = entry.mean;
+        double dt = jd - mean.epoch;
+        a = mean.a + mean.aRate * dt;
+        e = mean.e + mean.eRate * dt;
+        double i = (mean.i + mean.iRate * dt) * DEG;
+        double L = (mean.L + mean.LRate * dt) * DEG;
+        double varpi = (mean.varpi + mean.varpiRate * dt) * DEG;
+        double node = (mean.node + mean.nodeRate * dt) * DEG;
+        m = L - varpi;
+
+        double w = varpi - node;
+        double cw = cos(w), sw = sin(w), cn = cos(node), sn = sin(node), ci = cos(i), si = sin(i);
+        p[0] = cw * cn - sw * sn * ci;
+        p[1] = cw * sn + sw * cn * ci;
+        p[2] = sw * si;
+        q[0] = -sw * cn - cw * sn * ci;
+        q[1] = -sw * sn + cw * cn * ci;
+        q[2] = cw * si;
+    }
+
+    double E = solveKepler(m, e);
+    double x = a * (cos(E) - e);
+    double y = a * sqrt(1 - e * e) * sin(E);
+    for (int c = 0; c < 3; c++)
+        pos[c] = x * p[c] + y * q[c];
+    return osculating;
+}
+
+void KeplerEphemeris::earthPosition(double jd, double pos[3]) {
+    // Osculating elements of the Earth come from its own state, the mean elements are the barycentre's
+    if (this->orbitPosition(this->entries[this->earthSlot], jd, pos))
+        return;
+    double moon[3];
+    this->orbitPosition(this->entries[this->moonSlot], jd, moon);
+    for (int c = 0; c < 3; c++)
+        pos[c] -= MOON_MASS_FRACTION * moon[c];
+}
+
+void KeplerEphemeris::bodyPosition(Entry &entry, double jd, const double earth[3], double pos[3]) {
+    switch (entry.kind) {
+    case SUN:
+        for (int c = 0; c < 3; c++)
+            pos[c] = -earth[c];
+        break;
+    case EARTH:
+        pos[0] = pos[1] = pos[2] = 0;
+        break;
+    case GEOCENTRIC:
+        this->orbitPosition(entry, jd, pos);
+        break;
+    case HELIOCENTRIC:
+        this->orbitPosition(entry, jd, pos);
+        for (int c = 0; c < 3; c++)
+            pos[c] -= earth[c];
+        break;
+    case L2:
+        if (entry.hasOsculating && fabs(jd - entry.osculating.epoch) <= entry.osculatingSpan) {
+            this->orbitPosition(entry, jd, pos);
+            for (int c = 0; c < 3; c++)
+                pos[c] -= earth[c];
+        } else {
+            for (int c = 0; c < 3; c++)
+                pos[c] = earth[c] * L2_DISTANCE_RATIO;
+        }
+        break;
+    }
+}
+
+//===============================================================================================================
+// Helper Functions
+//===============================================================================================================
+static double solveKepler(double m, double e) {
+    m = remainder(m, 2 * M_PI);
+    double E = m + e * sin(m);
+    for (int k = 0; k < 8; k++) {
+        double dE = (E - e * sin(E) - m) / (1 - e * cos(E));
+        E -= dE;
+        if (fabs(dE) < 1e-12)
+            break;
+    }
+    return E;
+}
+
+static bool orbitFromState(const double r[3], const double v[3], double mu, double &a, double &e, double p[3], double q[3], double &m0, double &n) {
+    double rmag = sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]);
+    double v2 = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+    double rv = r[0] * v[0] + r[1] * v[1] + r[2] * v[2];
+    double h[3] = {r[1] * v[2] - r[2] * v[1], r[2] * v[0] - r[0] * v[2], r[0] * v[1] - r[1] * v[0]};
+    double hmag = sqrt(h[0] * h[0] + h[1] * h[1] + h[2] * h[2]);
+    if (rmag == 0 || hmag == 0)
+        return false;
+
+    double ev[3];
+    for (int c = 0; c < 3; c++)
+        ev[c] = ((v2 - mu / rmag) * r[c] - rv * v[c]) / mu;
+    double ecc = sqrt(ev[0] * ev[0] + ev[1] * ev[1] + ev[2] * ev[2]);
+    double axis = 1 / (2 / rmag - v2 / mu);
+    if (ecc >= 1 || axis <= 0)
+        return false;
+
+    // Perifocal frame: P towards the periapsis (the current position for a circular orbit), Q 90 deg ahead
+    double w[3] = {h[0] / hmag, h[1] / hmag, h[2] / hmag};
+    for (int c = 0; c < 3; c++)
+        p[c] = (ecc > 1e-10) ? ev[c] / ecc : r[c] / rmag;
+    q[0] = w[1] * p[2] - w[2] * p[1];
+    q[1] = w[2] * p[0] - w[0] * p[2];
+    q[2] = w[0] * p[1] - w[1] * p[0];
+
+    double cosNu = (p[0] * r[0] + p[1] * r[1] + p[2] * r[2]) / rmag;
+    double sinNu = (q[0] * r[0] + q[1] * r[1] + q[2] * r[2]) / rmag;
+    double E = atan2(sqrt(1 - ecc * ecc) * sinNu, ecc + cosNu);
+    a = axis;
+    e = ecc;
+    m0 = E - ecc * sin(E);
+    n = sqrt(mu / (axis * axis * axis)) * 86400.0;
+    return true;
+}
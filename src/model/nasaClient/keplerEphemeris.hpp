@@ -0,0 +1,134 @@
+#ifndef KeplerEphemeris_h
+#define KeplerEphemeris_h
+
+#include <stddef.h>
+#include <vector>
+#include "trajectory.hpp"
+
+/**
+ * @brief Position error of the analytic ephemeris against Horizons samples (km)
+ *
+ */
+struct KeplerError {
+    double rms;
+    double max;
+    size_t samples;     // 0 if the body was never compared
+};
+
+/**
+ * @brief Analytic ephemeris of the bodies in the Horizons frame the client uses (geocentric, ecliptic J2000, km).
+ * Planets follow the mean orbital elements and secular rates of Standish, "Keplerian Elements for Approximate
+ * Positions of the Major Planets" (JPL, valid 1800-2050), the Moon follows mean elements with the secular
+ * motion of its node and perigee, and the telescope sits at the Sun-Earth L2 point.
+ * Once a Horizons state vector of a body is known its osculating elements take over near that epoch.
+ * An evaluation is a Kepler equation solve and a few trigonometric calls, no allocation.
+ *
+ */
+class KeplerEphemeris {
+private:
+    enum Kind {
+        SUN,            // the Sun, opposite of the Earth's heliocentric position
+        EARTH,          // the geocentre itself
+        HELIOCENTRIC,   // orbit around the Sun
+        GEOCENTRIC,     // orbit around the Earth
+        L2              // Sun-Earth L2 point
+    };
+
+    /**
+     * @brief Mean elements at an epoch with their rates per day (km, deg, deg/day)
+     *
+     */
+    struct MeanElements {
+        double epoch;
+        double a, e, i, L, varpi, node;
+        double aRate, eRate, iRate, LRate, varpiRate, nodeRate;
+    };
+
+    /**
+     * @brief Osculating conic from a state vector: semi-major axis (km), eccentricity, perifocal axes P and Q,
+     * mean anomaly at the epoch and mean motion (rad/day)
+     *
+     */
+    struct Orbit {
+        double epoch;
+        double a, e;
+        double p[3], q[3];
+        double m0, n;
+    };
+
+    struct Entry {
+        long index;
+        Kind kind;
+        double radius;              // mean radius (km), used until Horizons provides one
+        MeanElements mean;
+        bool hasOsculating;
+        Orbit osculating;
+        double osculatingSpan;      // days from the osculating epoch where it beats the mean elements
+        KeplerError error;
+    };
+
+    std::vector<Entry> entries;
+    long earthSlot;
+    long moonSlot;
+
+    long slotOf(long index);
+    bool orbitPosition(Entry &entry, double jd, double pos[3]);
+    void earthPosition(double jd, double pos[3]);
+    void bodyPosition(Entry &entry, double jd, const double earth[3], double pos[3]);
+
+public:
+    KeplerEphemeris();
+
+    /**
+     * @brief Check if a body (Horizons index) has an analytic model
+     *
+     */
+    bool hasBody(long index);
+
+    /**
+     * @brief Mean radius of a body (km), 0 if unknown
+     *
+     */
+    double getRadius(long index);
+
+    /**
+     * @brief Refine a body with its Horizons state at a date. Geocentric states are converted to
+     * heliocentric ones with the Sun's state at the same date.
+     *
+     * @param pos geocentric position of the body (km)
+     * @param vel geocentric velocity of the body (km/s)
+     * @param sunPos geocentric position of the Sun (km)
+     * @param sunVel geocentric velocity of the Sun (km/s)
+     * @return false if the state does not describe a bound orbit
+     */
+    bool setState(long index, double jd, const double pos[3], const double vel[3], const double sunPos[3], const double sunVel[3]);
+
+    /**
+     * @brief Geocentric position of a body at a Julian date (km)
+     *
+     * @return false if the body has no analytic model
+     */
+    bool getPos(long index, double jd, double pos[3]);
+
+    /**
+     * @brief Geocentric positions of several bodies at the same date, sharing the Earth's position
+     *
+     * @param pos output, 3 * n positions (km)
+     * @param valid output, n flags set to false for bodies without analytic model
+     */
+    void getPositions(const long *indices, size_t n, double jd, double *pos, bool *valid);
+
+    /**
+     * @brief Compare a body with every sample of its Horizons trajectory and keep the result, see getError
+     *
+     */
+    void measureError(long index, Trajectory &trajectory);
+
+    /**
+     * @brief Last error measured for a body, samples is 0 if it was never measured
+     *
+     */
+    KeplerError getError(long index);
+};
+
+#endif
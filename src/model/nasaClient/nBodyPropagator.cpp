@@ -0,0 +1,228 @@
+#include "nBodyPropagator.hpp"
+
+#include <math.h>
+
+//===============================================================================================================
+// Constants Definition
+//===============================================================================================================
+static const double SECONDS_PER_DAY = 86400.0;
+static const double DEFAULT_STEP = 1.0 / 24.0;     // days
+static const double PADDING_DISTANCE = 1e30;        // km, padding slots are far away and massless
+static const long EARTH = 399;
+
+/**
+ * @brief Gravitational parameters (km^3/s^2) of the DE440 planetary ephemeris by Horizons index,
+ * planets with moons use their system value
+ *
+ */
+struct BodyGM {
+    long index;
+    double gm;
+};
+
+static const BodyGM MASSES[] = {
+    {10,  1.32712440041279e11},
+    {1,   22031.868551},
+    {2,   324858.592000},
+    {399, 398600.435507},
+    {301, 4902.800118},
+    {499, 42828.375816},
+    {599, 126712764.100000},
+    {699, 37940584.841800},
+    {799, 5794556.400000},
+    {899, 6836527.100580}
+};
+
+//===============================================================================================================
+// NBodyPropagator Class
+//...............................................................................................................
+// Constructor
+//...............................................................................................................
+NBodyPropagator::NBodyPropagator() {
+    this->step = DEFAULT_STEP;
+    this->clear();
+}
+
+//...............................................................................................................
+// Public Methods
+//...............................................................................................................
+void NBodyPropagator::clear() {
+    for (std::vector<double> *column : {&this->x, &this->y, &this->z, &this->vx, &this->vy, &this->vz,
+                                        &this->ax, &this->ay, &this->az, &this->gm})
+        column->clear();
+    this->indices.clear();
+    this->count = 0;
+    this->earthSlot = -1;
+    this->epoch = 0;
+    this->accelerated = false;
+}
+
+void NBodyPropagator::addBody(long index, double jd, const double pos[3], const double vel[3]) {
+    double gm = 0;
+    for (const BodyGM &mass : MASSES) {
+        if (mass.index == index)
+            gm = mass.gm;
+    }
+
+    // Reuse the first padding slot, or grow the arrays by a whole block of padding
+    if (this->count == this->indices.size()) {
+        for (size_t lane = 0; lane < LANES; lane++) {
+            this->indices.push_back(0);
+            for (std::vector<double> *column : {&this->x, &this->y, &this->z})
+                column->push_back(PADDING_DISTANCE * (lane + 1));
+            for (std::vector<double> *column : {&this->vx, &this->vy, &this->vz, &this->ax, &this->ay, &this->az, &this->gm})
+                column->push_back(0);
+        }
+    }
+
+    size_t slot = this->count++;
+    this->indices[slot] = index;
+    this->x[slot] = pos[0];
+    this->y[slot] = pos[1];
+    this->z[slot] = pos[2];
+    this->vx[slot] = vel[0];
+    this->vy[slot] = vel[1];
+    this->vz[slot] = vel[2];
+    this->gm[slot] = gm;
+    if (index == EARTH)
+        this->earthSlot = slot;
+    this->epoch = jd;
+    this->accelerated = false;
+}
+
+size_t NBodyPropagator::size() {
+    return this->count;
+}
+
+bool NBodyPropagator::hasBody(long index) {
+    return this->slotOf(index) >= 0;
+}
+
+double NBodyPropagator::getEpoch() {
+    return this->epoch;
+}
+
+void NBodyPropagator::setStep(double days) {
+    if (days > 0)
+        this->step = days;
+}
+
+bool NBodyPropagator::setGM(long index, double gm) {
+    long slot = this->slotOf(index);
+    if (slot < 0)
+        return false;
+    this->gm[slot] = gm;
+    this->accelerated = false;
+    return true;
+}
+
+bool NBodyPropagator::kick(long index, const double deltaV[3]) {
+    long slot = this->slotOf(index);
+    if (slot < 0)
+        return false;
+    this->vx[slot] += deltaV[0];
+    this->vy[slot] += deltaV[1];
+    this->vz[slot] += deltaV[2];
+    return true;
+}
+
+void NBodyPropagator::propagate(double jd) {
+    if (this->count == 0)
+        return;
+
+    // Equal steps no longer than the step size, landing exactly on the date
+    double span = jd - this->epoch;
+    long steps = (long)ceil(fabs(span) / this->step);
+    if (steps == 0)
+        return;
+    double dt = span / steps * SECONDS_PER_DAY;
+    for (long i = 0; i < steps; i++)
+        this->leapfrog(dt);
+    this->epoch = jd;
+}
+
+bool NBodyPropagator::getPos(long index, double pos[3]) {
+    bool valid;
+    this->getPositions(&index, 1, pos, &valid);
+    return valid;
+}
+
+void NBodyPropagator::getPositions(const long *indices, size_t n, double *pos, bool *valid) {
+    double earth[3] = {0, 0, 0};
+    if (this->earthSlot >= 0) {
+        earth[0] = this->x[this->earthSlot];
+        earth[1] = this->y[this->earthSlot];
+        earth[2] = this->z[this->earthSlot];
+    }
+    for (size_t i = 0; i < n; i++) {
+        long slot = this->slotOf(indices[i]);
+        valid[i] = slot >= 0;
+        if (!valid[i])
+            continue;
+        pos[3 * i] = this->x[slot] - earth[0];
+        pos[3 * i + 1] = this->y[slot] - earth[1];
+        pos[3 * i + 2] = this->z[slot] - earth[2];
+    }
+}
+
+//...............................................................................................................
+// Private Methods
+//...............................................................................................................
+long NBodyPropagator::slotOf(long index) {
+    for (size_t slot = 0; slot < this->count; slot++) {
+        if (this->indices[slot] == index)
+            return slot;
+    }
+    return -1;
+}
+
+void NBodyPropagator::accelerate() {
+    size_t padded = this->x.size();
+    const double *x = this->x.data(), *y = this->y.data(), *z = this->z.data(), *gm = this->gm.data();
+    for (size_t i = 0; i < this->count; i++) {
+        double sum[3][LANES] = {};
+        for (size_t block = 0; block < padded; block += LANES) {
+            // One lane per attracting body, the body itself gives a zero vector and a unit distance
+            for (size_t lane = 0; lane < LANES; lane++) {
+                size_t j = block + lane;
+                double dx = x[j] - x[i];
+                double dy = y[j] - y[i];
+                double dz = z[j] - z[i];
+                double r2 = dx * dx + dy * dy + dz * dz;
+                r2 += (r2 == 0) ? 1.0 : 0.0;
+                double scale = gm[j] / (r2 * sqrt(r2));
+                sum[0][lane] += scale * dx;
+                sum[1][lane] += scale * dy;
+                sum[2][lane] += scale * dz;
+            }
+        }
+        this->ax[i] = this->ay[i] = this->az[i] = 0;
+        for (size_t lane = 0; lane < LANES; lane++) {
+            this->ax[i] += sum[0][lane];
+            this->ay[i] += sum[1][lane];
+            this->az[i] += sum[2][lane];
+        }
+    }
+    this->accelerated = true;
+}
+
+void NBodyPropagator::leapfrog(double dt) {
+    if (!this->accelerated)
+        this->accelerate();
+
+    double half = dt / 2;
+    for (size_t i = 0; i < this->count; i++) {
+        this->vx[i] += half * this->ax[i];
+        this->vy[i] += half * this->ay[i];
+        this->vz[i] += half * this->az[i];
+        this->x[i] += dt * this->vx[i];
+        this->y[i] += dt * this->vy[i];
+        this->z[i] += dt * this->vz[i];
+    }
+    this->accelerate();
+    for (size_t i = 0; i < this->count; i++) {
+        this->vx[i] += half * this->ax[i];
+        this->vy[i] += half * this->ay[i];
+        this->vz[i] += half * this->az[i];
+    }
+}
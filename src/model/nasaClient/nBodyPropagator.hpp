@@ -0,0 +1,96 @@
+#ifndef NBodyPropagator_h
+#define NBodyPropagator_h
+
+#include <stddef.h>
+#include <vector>
+
+/**
+ * @brief Newtonian N-body integration of the bodies from one snapshot of their state vectors, forward or
+ * backward in time without any further Horizons data.
+ * States are geocentric (ecliptic J2000, km, km/s) at the snapshot, a frame that moves uniformly and is
+ * therefore inertial, and positions are given back relative to the integrated Earth.
+ * The integrator is a kick-drift-kick leapfrog, symplectic and time reversible, so stepping back and forth
+ * over the same dates keeps the energy bounded. Bodies are kept as arrays of each coordinate and the
+ * pairwise forces run over fixed width blocks the compiler turns into vector instructions.
+ *
+ */
+class NBodyPropagator {
+private:
+    static const size_t LANES = 4;  // block width of the force kernel, the arrays are padded to it
+
+    std::vector<long> indices;
+    std::vector<double> x, y, z;
+    std::vector<double> vx, vy, vz;
+    std::vector<double> ax, ay, az;
+    std::vector<double> gm;         // km^3/s^2, 0 for test particles and padding
+    size_t count;
+    long earthSlot;
+    double epoch;                   // Julian date of the current state
+    double step;                    // largest step (days)
+    bool accelerated;               // accelerations match the current positions
+
+    long slotOf(long index);
+    void accelerate();
+    void leapfrog(double dt);
+
+public:
+    NBodyPropagator();
+
+    /**
+     * @brief Drop every body, the next addBody starts a new snapshot
+     *
+     */
+    void clear();
+
+    /**
+     * @brief Add a body of the snapshot, every body is given at the same date. The mass comes from the
+     * body's Horizons index, unknown bodies (e.g. spacecraft) are test particles.
+     *
+     */
+    void addBody(long index, double jd, const double pos[3], const double vel[3]);
+
+    size_t size();
+    bool hasBody(long index);
+    double getEpoch();
+
+    /**
+     * @brief Set the largest integration step (days), a step of a few hours keeps the Moon accurate
+     *
+     */
+    void setStep(double days);
+
+    /**
+     * @brief Change the gravitational parameter of a body (km^3/s^2) from the current date on
+     *
+     */
+    bool setGM(long index, double gm);
+
+    /**
+     * @brief Add a velocity change to a body at the current date (km/s)
+     *
+     */
+    bool kick(long index, const double deltaV[3]);
+
+    /**
+     * @brief Integrate the whole system from the current date to another one, before or after it
+     *
+     */
+    void propagate(double jd);
+
+    /**
+     * @brief Geocentric position of a body at the current date (km)
+     *
+     * @return false if the body is not part of the snapshot
+     */
+    bool getPos(long index, double pos[3]);
+
+    /**
+     * @brief Geocentric positions of several bodies at the current date
+     *
+     * @param pos output, 3 * n positions (km)
+     * @param valid output, n flags set to false for bodies outside the snapshot
+     */
+    void getPositions(const long *indices, size_t n, double *pos, bool *valid);
+};
+
+#endif
@@ -1,12 +1,14 @@
 #include "nasaClient.hpp"
-#include "json.hpp"
+#include "julianDate.hpp"
 
-#include <map>
 #include <iostream>
 #include <stdlib.h>
 #include <regex>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
 
-using json = nlohmann::json;
 using std::cout;
 using std::endl;
 using std::cerr;
@@ -16,24 +18,10 @@ using std::cerr;
 //===============================================================================================================
 
 static size_t cb(void *data, size_t size, size_t nmemb, void *clientp);
-struct memory {
-  char *response;
-  size_t size;
-};
-
-std::map<std::string, long>objects = {
-    {"Sun", 10},
-    {"Mercury", 1},
-    {"Venus", 2},
-    {"Earth", 399},
-    {"Moon", 301},
-    {"Mars", 499},
-    {"Jupiter", 599},
-    {"Saturn", 699},
-    {"Uranus", 799},
-    {"Neptune", 899},
-    {"JWS", -170}
-};
+
+const char *EPHEMERIS_CACHE_PATH = "cache/ephemeris.bin";
+const size_t REPLAY_CHUNK_SIZE = CURL_MAX_WRITE_SIZE;  // replayed responses reach the parser in chunks like live ones
+const long SUN_INDEX = 10;
 
 //===============================================================================================================
 // NasaClient Class
@@ -41,11 +29,42 @@ std::map<std::string, long>objects = {
 // Constructor and Destructor
 //...............................................................................................................
 NasaClient::NasaClient() {
-    this->curl = curl_easy_init();
+    // Benchmarks point the cache at a scratch file to start cold
+    const char *cachePath = getenv("SPACE_EPHEMERIS_CACHE");
+    this->cache = new EphemerisCache((cachePath != NULL) ? cachePath : EPHEMERIS_CACHE_PATH);
+
+    this->mode = LIVE;
+    this->fixtures = NULL;
+    const char *recordDirectory = getenv("SPACE_RECORD_DIR");
+    const char *replayDirectory = getenv("SPACE_REPLAY_DIR");
+    if (replayDirectory != NULL) {
+        const char *latency = getenv("SPACE_REPLAY_LATENCY");
+        const char *seed = getenv("SPACE_REPLAY_SEED");
+        if (!this->setReplayDirectory(replayDirectory, (latency != NULL) ? latency : "", (seed != NULL) ? atol(seed) : 0))
+            cerr << "Invalid SPACE_REPLAY_LATENCY, replaying without latency" << endl;
+    } else if (recordDirectory != NULL) {
+        this->setRecordDirectory(recordDirectory);
+    }
+
+    // Share DNS, TLS sessions and open connections between the Horizons transfers
+    this->share = curl_share_init();
+    curl_share_setopt(this->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(this->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_share_setopt(this->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+
+    this->multi = curl_multi_init();
+    curl_multi_setopt(this->multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
 }
 
 NasaClient::~NasaClient() {
-    curl_easy_cleanup(this->curl);
+    for (HorizonsTransfer *transfer : this->transfers) {
+        curl_easy_cleanup(transfer->handle);
+        delete transfer;
+    }
+    curl_multi_cleanup(this->multi);
+    curl_share_cleanup(this->share);
+    delete this->fixtures;
+    delete this->cache;
 }
 
 
@@ -61,66 +80,97 @@ void NasaClient::setKey(std::string key) {
     this->apiKey = key;
 }
 
+void NasaClient::setRecordDirectory(std::string directory) {
+    delete this->fixtures;
+    this->fixtures = new HttpFixtures(directory);
+    this->mode = RECORD;
+}
+
+bool NasaClient::setReplayDirectory(std::string directory, std::string latency, uint32_t seed) {
+    delete this->fixtures;
+    this->fixtures = new HttpFixtures(directory);
+    this->mode = REPLAY;
+    this->latency.seed(seed);
+    return this->latency.parse(latency);
+}
+
 void NasaClient::getBodyData(Body &body, std::string date) {
     if (body.getDataDate() == date)
         return;
-    struct memory chunk = {0};
-    std::string juliandDate = this->getJulianDate(date);
-    std::string endpoint = "https://ssd.jpl.nasa.gov/api/horizons.api?COMMAND='" + std::to_string(body.getIndex()) + "'" +
-                            "&EPHEM_TYPE='VECTORS'" +
-                            "&START_TIME='JD" + juliandDate.c_str() + "'" +
-                            "&STOP_TIME='JD" + std::to_string(atol(juliandDate.c_str()) + 1) + "'" +
-                            "&STEP_SIZE='1d'";
-    curl_easy_setopt(this->curl, CURLOPT_URL, endpoint.c_str());
-    curl_easy_setopt(this->curl, CURLOPT_WRITEFUNCTION, cb);
-    curl_easy_setopt(this->curl, CURLOPT_WRITEDATA, (void *)&chunk);
-    curl_easy_perform(curl);
-    json data = json::parse(chunk.response);
-    free(chunk.response);
-    std::string result = data["result"];
-
-    // Get Position Data
-    size_t index[4];
-    index[0] = result.find("X =");
-    index[1] = result.find("Y =");
-    index[2] = result.find("Z =");
-    index[3] = result.find("VX=");
-    char values[3][BUFSIZ];
-    for (int i=0; i<3; i++) {
-        int offset = 3;
-        int additionalOffset = 1;
-        if (i == 2)
-            additionalOffset ++;
-        int len = index[i+1] - index[i] - (offset + additionalOffset);
-        result.copy(values[i], len, index[i]+offset);
+    double jd;
+    if (!this->toJulian(date, jd) || this->getCachedBodyData(body, jd, date))
+        return;
+    std::vector<std::string> endpoints = {this->getBodyEndpoint(body, jd, floor(jd) + 1)};
+    std::vector<bool> completed;
+    this->fetchAll(endpoints, completed);
+    if (completed[0])
+        this->parseBodyData(body, this->transfers[0]->stream, date, jd);
+    else
+        cerr << "Failed to get data for " << body.getName() << endl;
+}
+
+void NasaClient::getBodiesData(std::vector<Body *> &bodies, std::string date) {
+    double jd;
+    if (!this->toJulian(date, jd))
+        return;
+
+    std::vector<Body *> pending;
+    for (Body *body : bodies) {
+        if (body->getDataDate() != date && !this->getCachedBodyData(*body, jd, date))
+            pending.push_back(body);
     }
-    glm::vec3 pos(atof(values[0]), atof(values[1]), atof(values[2]));
+    if (pending.empty())
+        return;
 
-    // Get Physical Data
-    //Radius
-    float radius = 0;
-    if (body.getIndex() > 0) {
-        std::string radiusTag[3] = {"radius", "= ", " "};
-        size_t radiusIndex[3];
-        radiusIndex[0] = result.find(radiusTag[0]);
-        radiusIndex[1] = result.find(radiusTag[1], radiusIndex[0]) + radiusTag[1].length();
-        radiusIndex[2] = result.find(radiusTag[2], radiusIndex[1]);
-        char radiusText[BUFSIZ];
-        result.copy(radiusText, radiusIndex[2] - radiusIndex[1], radiusIndex[1]);
-        radius = atof(radiusText);
-        if (radius == 0) {
-            std::string secondaryTag[3] = {"Radius (km) ", "=  ", " "};
-            radiusIndex[0] = result.find(secondaryTag[0]);
-            radiusIndex[1] = result.find(secondaryTag[1], radiusIndex[0]) + secondaryTag[1].length();
-            radiusIndex[2] = result.find(secondaryTag[2], radiusIndex[1]);
-            char radiusText[BUFSIZ];
-            result.copy(radiusText, radiusIndex[2] - radiusIndex[1], radiusIndex[1]);
-            radius = atof(radiusText);
-        }
+    std::vector<std::string> endpoints;
+    for (Body *body : pending)
+        endpoints.push_back(this->getBodyEndpoint(*body, jd, floor(jd) + 1));
+    std::vector<bool> completed;
+    this->fetchAll(endpoints, completed);
+
+    for (size_t i = 0; i < pending.size(); i++) {
+        if (completed[i])
+            this->parseBodyData(*pending[i], this->transfers[i]->stream, date, jd);
+        else
+            cerr << "Failed to get data for " << pending[i]->getName() << endl;
     }
+}
 
-    //Update Data
-    body.updateData(pos, radius, date);
+void NasaClient::getBodiesWindow(std::vector<Body *> &bodies, std::vector<Trajectory *> &trajectories, double startJd, double stopJd) {
+    std::vector<size_t> pending;
+    for (size_t i = 0; i < bodies.size(); i++) {
+        if (!this->getCachedTrajectory(*bodies[i], *trajectories[i], startJd, stopJd))
+            pending.push_back(i);
+    }
+    if (pending.empty())
+        return;
+
+    std::vector<std::string> endpoints;
+    for (size_t i : pending)
+        endpoints.push_back(this->getBodyEndpoint(*bodies[i], startJd, stopJd));
+    std::vector<bool> completed;
+    this->fetchAll(endpoints, completed);
+
+    for (size_t j = 0; j < pending.size(); j++) {
+        Body &body = *bodies[pending[j]];
+        Trajectory &trajectory = *trajectories[pending[j]];
+        if (completed[j])
+            this->parseTrajectory(body, this->transfers[j]->stream, trajectory);
+        else
+            cerr << "Failed to get trajectory for " << body.getName() << endl;
+    }
+}
+
+bool NasaClient::getNearestCachedState(Body &body, double jd, EphemerisRecord &state, EphemerisRecord &sunState) {
+    const EphemerisRecord *record = this->cache->findNearest(body.getIndex(), jd);
+    if (record == NULL)
+        return false;
+    state = *record;
+    const EphemerisRecord *sunRecord = this->cache->find(SUN_INDEX, state.jd);
+    if (sunRecord == NULL)
+        return false;
+    sunState = *sunRecord;
+    return true;
 }
 
 void NasaClient::test() {
@@ -131,39 +181,204 @@ void NasaClient::test() {
     cerr << "Converted Julian Date: " << julianDate << endl;
     std::string calendarDate = this->getCalendarDate(std::to_string(atol(julianDate.c_str()) + 1));
     cerr << "Converted provided Julian Date to Calendar Date: " << calendarDate << endl;
-    Body sun("Sun");
+    Body sun("Sun", SUN_INDEX);
     this->getBodyData(sun, "2023-03-07");
-    Body jws("JWS");
+    Body jws("JWS", -170);
     this->getBodyData(jws, "2023-03-07");
     cerr << "Cleaned up Curl" << endl;
 }
 
 //...............................................................................................................
 // Private Methods
-// Judlian Date API: https://ssd-api.jpl.nasa.gov/doc/jd_cal.html
+// Judlian Date API (now computed locally, see julianDate.hpp): https://ssd-api.jpl.nasa.gov/doc/jd_cal.html
 // Horizon API: https://ssd-api.jpl.nasa.gov/doc/horizons.html
 // Horizon Application: https://ssd.jpl.nasa.gov/horizons/app.html#/
 //...............................................................................................................
 
-std::string NasaClient::getJulianDate(std::string calendarDate) {
-    return convertDate(calendarDate, "cd", "jd");
+std::string NasaClient::getBodyEndpoint(Body &body, double startJd, double stopJd) {
+    char start[32];
+    char stop[32];
+    julian::formatJulian(startJd, start, sizeof(start));
+    julian::formatJulian(stopJd, stop, sizeof(stop));
+    return "https://ssd.jpl.nasa.gov/api/horizons.api?COMMAND='" + std::to_string(body.getIndex()) + "'" +
+            "&EPHEM_TYPE='VECTORS'" +
+            "&START_TIME='JD" + start + "'" +
+            "&STOP_TIME='JD" + stop + "'" +
+            "&STEP_SIZE='1d'";
 }
 
-std::string NasaClient::getCalendarDate(std::string julianDate) {
-    return convertDate(julianDate, "jd", "cd");
+void NasaClient::fetchAll(std::vector<std::string> &endpoints, std::vector<bool> &completed) {
+    while (this->transfers.size() < endpoints.size()) {
+        HorizonsTransfer *transfer = new HorizonsTransfer();
+        transfer->handle = curl_easy_init();
+        transfer->recording = NULL;
+        this->transfers.push_back(transfer);
+    }
+    if (this->mode == REPLAY) {
+        this->replayAll(endpoints, completed);
+        return;
+    }
+
+    for (size_t i = 0; i < endpoints.size(); i++) {
+        HorizonsTransfer *transfer = this->transfers[i];
+        transfer->stream.reset();
+        if (this->mode == RECORD)
+            transfer->recording = this->fixtures->beginRecording(endpoints[i]);
+        curl_easy_setopt(transfer->handle, CURLOPT_URL, endpoints[i].c_str());
+        curl_easy_setopt(transfer->handle, CURLOPT_WRITEFUNCTION, cb);
+        curl_easy_setopt(transfer->handle, CURLOPT_WRITEDATA, (void *)transfer);
+        curl_easy_setopt(transfer->handle, CURLOPT_PRIVATE, (void *)i);
+        curl_easy_setopt(transfer->handle, CURLOPT_SHARE, this->share);
+        curl_easy_setopt(transfer->handle, CURLOPT_PIPEWAIT, 1L);
+        curl_multi_add_handle(this->multi, transfer->handle);
+    }
+
+    // Drive every transfer until all have completed
+    int running = 0;
+    do {
+        CURLMcode mc = curl_multi_perform(this->multi, &running);
+        if (mc == CURLM_OK && running)
+            mc = curl_multi_poll(this->multi, NULL, 0, 1000, NULL);
+        if (mc != CURLM_OK) {
+            cerr << "curl multi failed: " << curl_multi_strerror(mc) << endl;
+            break;
+        }
+    } while (running);
+
+    completed.assign(endpoints.size(), false);
+    CURLMsg *msg;
+    int queued;
+    while ((msg = curl_multi_info_read(this->multi, &queued)) != NULL) {
+        if (msg->msg != CURLMSG_DONE)
+            continue;
+        void *privateData;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &privateData);
+        size_t i = (size_t)privateData;
+        completed[i] = msg->data.result == CURLE_OK;
+        if (!completed[i])
+            cerr << "libcurl: " << curl_easy_strerror(msg->data.result) << endl;
+    }
+
+    for (size_t i = 0; i < endpoints.size(); i++) {
+        HorizonsTransfer *transfer = this->transfers[i];
+        curl_multi_remove_handle(this->multi, transfer->handle);
+        if (transfer->recording != NULL)
+            this->fixtures->endRecording(transfer->recording, endpoints[i], completed[i]);
+        transfer->recording = NULL;
+    }
 }
 
-std::string NasaClient::convertDate(std::string date, std::string dateType, std::string returnDateType) {
-    struct memory chunk = {0};
-    std::string converterEndpoint = "https://ssd-api.jpl.nasa.gov/jd_cal.api?" + dateType + "=" + date;
-    // curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
-    curl_easy_setopt(this->curl, CURLOPT_URL, converterEndpoint.c_str());
-    curl_easy_setopt(this->curl, CURLOPT_WRITEFUNCTION, cb);
-    curl_easy_setopt(this->curl, CURLOPT_WRITEDATA, (void *)&chunk);
-    curl_easy_perform(curl);
-    json data = json::parse(chunk.response);
-    free(chunk.response);
-    return data[returnDateType];
+void NasaClient::replayAll(std::vector<std::string> &endpoints, std::vector<bool> &completed) {
+    // Requests run concurrently, so each response lands at its own latency after the start, earliest first
+    std::vector<std::pair<double, size_t>> arrivals;
+    for (size_t i = 0; i < endpoints.size(); i++)
+        arrivals.push_back({this->latency.sample(), i});
+    std::sort(arrivals.begin(), arrivals.end());
+
+    completed.assign(endpoints.size(), false);
+    auto start = std::chrono::steady_clock::now();
+    for (auto const& arrival : arrivals) {
+        std::this_thread::sleep_until(start + std::chrono::duration<double, std::milli>(arrival.first));
+        size_t i = arrival.second;
+        HorizonsStream &stream = this->transfers[i]->stream;
+        stream.reset();
+        if (!this->fixtures->load(endpoints[i], this->replayBuffer))
+            continue;
+        for (size_t offset = 0; offset < this->replayBuffer.size(); offset += REPLAY_CHUNK_SIZE) {
+            size_t size = std::min(REPLAY_CHUNK_SIZE, this->replayBuffer.size() - offset);
+            stream.write(this->replayBuffer.data() + offset, size);
+        }
+        completed[i] = true;
+    }
+}
+
+bool NasaClient::getCachedBodyData(Body &body, double jd, std::string date) {
+    const EphemerisRecord *record = this->cache->find(body.getIndex(), jd);
+    if (record == NULL)
+        return false;
+    body.updateState(glm::dvec3(record->pos[0], record->pos[1], record->pos[2]),
+                     glm::dvec3(record->vel[0], record->vel[1], record->vel[2]), record->radius, date);
+    return true;
+}
+
+void NasaClient::parseBodyData(Body &body, HorizonsStream &stream, std::string date, double jd) {
+    HorizonsParser &parser = stream.getParser();
+    if (!stream.isComplete() || parser.getRows().empty()) {
+        cerr << "No vector table for " << body.getName() << endl;
+        return;
+    }
+
+    // Get State Vector
+    const HorizonsRow &row = parser.getRows().front();
+    glm::dvec3 pos(row.pos[0], row.pos[1], row.pos[2]);
+    glm::dvec3 vel(row.vel[0], row.vel[1], row.vel[2]);
+
+    // Get Physical Data
+    float radius = (body.getIndex() > 0) ? parser.getRadius() : 0;
+
+    //Update Data
+    body.updateState(pos, vel, radius, date);
+    this->cache->insert({body.getIndex(), jd, {row.pos[0], row.pos[1], row.pos[2]}, {row.vel[0], row.vel[1], row.vel[2]}, radius});
+}
+
+bool NasaClient::getCachedTrajectory(Body &body, Trajectory &trajectory, double startJd, double stopJd) {
+    // Only use the cache when it holds every day of the window
+    for (double jd = startJd; jd <= stopJd; jd++) {
+        if (this->cache->find(body.getIndex(), jd) == NULL)
+            return false;
+    }
+    trajectory.clear();
+    trajectory.reserve((size_t)(stopJd - startJd) + 1);
+    for (double jd = startJd; jd <= stopJd; jd++) {
+        const EphemerisRecord *record = this->cache->find(body.getIndex(), jd);
+        trajectory.addSample(jd, record->pos[0], record->pos[1], record->pos[2],
+                             record->vel[0], record->vel[1], record->vel[2]);
+        trajectory.setRadius(record->radius);
+    }
+    return true;
+}
+
+void NasaClient::parseTrajectory(Body &body, HorizonsStream &stream, Trajectory &trajectory) {
+    trajectory.clear();
+    HorizonsParser &parser = stream.getParser();
+    if (!stream.isComplete()) {
+        cerr << "No vector table for " << body.getName() << endl;
+        return;
+    }
+
+    float radius = (body.getIndex() > 0) ? parser.getRadius() : 0;
+    const std::vector<HorizonsRow> &rows = parser.getRows();
+    trajectory.setRadius(radius);
+    trajectory.reserve(rows.size());
+    for (const HorizonsRow &row : rows) {
+        trajectory.addSample(row.jd, row.pos[0], row.pos[1], row.pos[2], row.vel[0], row.vel[1], row.vel[2]);
+        this->cache->insert({body.getIndex(), row.jd, {row.pos[0], row.pos[1], row.pos[2]}, {row.vel[0], row.vel[1], row.vel[2]}, radius});
+    }
+}
+
+bool NasaClient::toJulian(std::string calendarDate, double &jd) {
+    CalendarDate date;
+    if (!julian::parseCalendar(calendarDate.c_str(), date)) {
+        cerr << "Invalid calendar date: " << calendarDate << endl;
+        return false;
+    }
+    jd = julian::fromCalendar(date);
+    return true;
+}
+
+std::string NasaClient::getJulianDate(std::string calendarDate) {
+    double jd;
+    if (!this->toJulian(calendarDate, jd))
+        return "";
+    char buffer[32];
+    julian::formatJulian(jd, buffer, sizeof(buffer));
+    return buffer;
+}
+
+std::string NasaClient::getCalendarDate(std::string julianDate) {
+    char buffer[48];
+    julian::formatCalendar(julian::toCalendar(atof(julianDate.c_str())), buffer, sizeof(buffer));
+    return buffer;
 }
 
 //===============================================================================================================
@@ -172,10 +387,16 @@ std::string NasaClient::convertDate(std::string date, std::string dateType, std:
 // Construct
 //...............................................................................................................
 
-Body::Body(std::string name, glm::vec3 color) {
+Body::Body(std::string name, long index, glm::vec3 color) {
     this->name = name;
-    this->index = objects[name];
+    this->index = index;
     this->dataDate = "";
+    this->pos = glm::vec3(0, 0, 0);
+    this->statePos = glm::dvec3(0, 0, 0);
+    this->stateVel = glm::dvec3(0, 0, 0);
+    this->stateKnown = false;
+    this->radius = 0;
+    this->posError = 0;
     this->color = color;
 }
 
@@ -183,10 +404,19 @@ Body::Body(std::string name, glm::vec3 color) {
 // Public Functions
 //...............................................................................................................
 
-void Body::updateData(glm::vec3 pos, float radius, std::string dataDate) {
+void Body::updateData(glm::vec3 pos, float radius, std::string dataDate, float posError) {
     this->pos = pos;
+    this->posError = posError;
     this->radius = radius;
     this->dataDate = dataDate;
+    this->stateKnown = false;
+}
+
+void Body::updateState(glm::dvec3 pos, glm::dvec3 vel, float radius, std::string dataDate, float posError) {
+    this->updateData(glm::vec3(pos), radius, dataDate, posError);
+    this->statePos = pos;
+    this->stateVel = vel;
+    this->stateKnown = true;
 }
 
 std::string Body::getDataDate() {
@@ -205,6 +435,22 @@ glm::vec3 Body::getPos() {
     return this->pos;
 }
 
+bool Body::hasState() {
+    return this->stateKnown;
+}
+
+glm::dvec3 Body::getStatePos() {
+    return this->statePos;
+}
+
+glm::dvec3 Body::getStateVel() {
+    return this->stateVel;
+}
+
+float Body::getPosError() {
+    return this->posError;
+}
+
 float Body::getRadius() {
     return this->radius;
 }
@@ -230,19 +476,12 @@ GLuint Body::getTexId() {
 //===============================================================================================================
 static size_t cb(void *data, size_t size, size_t nmemb, void *clientp)
 {
+  // Parse the chunk right away instead of accumulating the whole response
   size_t realsize = size * nmemb;
-  struct memory *mem = (struct memory *)clientp;
- 
-  char *ptr = (char *)realloc(mem->response, mem->size + realsize + 1);
-  if(ptr == NULL)
-    return 0;  /* out of memory! */
- 
-  mem->response = ptr;
-  memcpy(&(mem->response[mem->size]), data, realsize);
-  mem->size += realsize;
-  mem->response[mem->size] = 0;
- 
-  return realsize;
+  HorizonsTransfer *transfer = (HorizonsTransfer *)clientp;
+  if (transfer->recording != NULL)
+    fwrite(data, 1, realsize, transfer->recording);
+  return transfer->stream.write((const char *)data, realsize);
 }
 
 
@@ -6,6 +6,10 @@
 #include <string>
 #include <vector>
 #include <glm/vec3.hpp>
+#include "ephemerisCache.hpp"
+#include "trajectory.hpp"
+#include "horizonsParser.hpp"
+#include "httpFixtures.hpp"
 
 #ifdef __APPLE__
 #include <GLUT/glut.h>
@@ -19,16 +23,39 @@ private:
     std::string name;
     long index;
     glm::vec3 pos;
+    glm::dvec3 statePos;    // full precision state vector (km, km/s), valid if hasState
+    glm::dvec3 stateVel;
+    bool stateKnown;
+    float posError;
     float radius;
     std::string dataDate;
     glm::vec3 color;
     GLuint texId;
 public:
-    Body(std::string name, glm::vec3 color=glm::vec3(1, 1, 1));
+    /**
+     * @brief Body with its Horizons index, see the body catalog
+     * 
+     */
+    Body(std::string name, long index, glm::vec3 color=glm::vec3(1, 1, 1));
+
+    void updateData(glm::vec3 pos, float radius, std::string dataDate, float posError=0);
 
-    void updateData(glm::vec3 pos, float radius, std::string dataDate);
+    /**
+     * @brief Update the body with a full state vector, the position is also used for rendering
+     * 
+     */
+    void updateState(glm::dvec3 pos, glm::dvec3 vel, float radius, std::string dataDate, float posError=0);
     std::string getDataDate();
     glm::vec3 getPos();
+
+    /**
+     * @brief Check if the last update carried a state vector, see getStatePos and getStateVel
+     * 
+     */
+    bool hasState();
+    glm::dvec3 getStatePos();
+    glm::dvec3 getStateVel();
+    float getPosError();
     float getRadius();
     std::string getName();
     long getIndex();
@@ -38,6 +65,16 @@ public:
     GLuint getTexId();
 };
 
+/**
+ * @brief One pooled Horizons transfer: an easy handle with its receive buffer and parser
+ * 
+ */
+struct HorizonsTransfer {
+    CURL *handle;
+    HorizonsStream stream;
+    FILE *recording;    // fixture file the response is written to, NULL unless recording
+};
+
 /**
  * @brief Client object used to load and define a client interface to the NASA APIs
  * 
@@ -45,16 +82,52 @@ public:
 class NasaClient {
 private:
     /**
-     * @brief storage of the curl object
+     * @brief connection, DNS and TLS session cache shared by every transfer
+     * 
+     */
+    CURLSH* share;
+    /**
+     * @brief multi handle used to run the Horizons requests of several bodies at once
      * 
      */
-    CURL* curl;
+    CURLM* multi;
+    /**
+     * @brief transfers reused by the multi handle between date changes
+     * 
+     */
+    std::vector<HorizonsTransfer*> transfers;
     std::string endpoint;
     std::string apiKey;
 
+    /**
+     * @brief parsed body data from previous runs, consulted before going to the network
+     * 
+     */
+    EphemerisCache* cache;
+    /**
+     * @brief where responses come from: the network, the network while recording fixtures, or fixtures only
+     * 
+     */
+    enum FetchMode {
+        LIVE,
+        RECORD,
+        REPLAY
+    };
+    FetchMode mode;
+    HttpFixtures *fixtures;
+    ReplayLatency latency;
+    std::vector<char> replayBuffer;
+
+    std::string getBodyEndpoint(Body &body, double startJd, double stopJd);
+    void fetchAll(std::vector<std::string> &endpoints, std::vector<bool> &completed);
+    void replayAll(std::vector<std::string> &endpoints, std::vector<bool> &completed);
+    bool getCachedBodyData(Body &body, double jd, std::string date);
+    bool getCachedTrajectory(Body &body, Trajectory &trajectory, double startJd, double stopJd);
+    void parseBodyData(Body &body, HorizonsStream &stream, std::string date, double jd);
+    void parseTrajectory(Body &body, HorizonsStream &stream, Trajectory &trajectory);
+    bool toJulian(std::string calendarDate, double &jd);
     std::string getJulianDate(std::string calendarDate);
     std::string getCalendarDate(std::string julianDate);
-    std::string convertDate(std::string date, std::string dateType, std::string returnDateType);
 
 public:
     /**
@@ -73,8 +146,53 @@ public:
 
     void setKey(std::string key);
 
+    /**
+     * @brief Fetch from the network and write every request URL and response body to a fixture directory
+     * 
+     */
+    void setRecordDirectory(std::string directory);
+
+    /**
+     * @brief Serve every request from a fixture directory written by setRecordDirectory, never touching the network
+     * 
+     * @param directory fixture directory
+     * @param latency simulated latency of each request: "", "fixed:<ms>", "uniform:<min>:<max>",
+     * "normal:<mean>:<stddev>" or "lognormal:<median ms>:<sigma>"
+     * @param seed seed of the latency generator, a run with the same seed sees the same latencies
+     * @return false if the latency description is not understood
+     */
+    bool setReplayDirectory(std::string directory, std::string latency="", uint32_t seed=0);
+
     void getBodyData(Body &body, std::string date);
 
+    /**
+     * @brief Update every body to the given date with all Horizons requests in flight at once.
+     * Returns once each body has been updated (or its request has failed).
+     * 
+     * @param bodies bodies to update, bodies already at the date are skipped
+     * @param date calendar date (yyyy-mm-dd)
+     */
+    void getBodiesData(std::vector<Body *> &bodies, std::string date);
+
+    /**
+     * @brief Fill each body's trajectory with daily samples from startJd to stopJd using one
+     * Horizons request per body, all in flight at once. Windows fully present in the cache are not fetched.
+     * 
+     * @param bodies bodies to fetch
+     * @param trajectories trajectory of each body, in the same order as bodies
+     * @param startJd first sample date (Julian date)
+     * @param stopJd last sample date (Julian date)
+     */
+    void getBodiesWindow(std::vector<Body *> &bodies, std::vector<Trajectory *> &trajectories, double startJd, double stopJd);
+
+    /**
+     * @brief Get the cached state of a body closest in time to a date, together with the Sun's state at
+     * the same date, without any fetch
+     * 
+     * @return false if no such pair of states is cached
+     */
+    bool getNearestCachedState(Body &body, double jd, EphemerisRecord &state, EphemerisRecord &sunState);
+
     /**
      * @brief Used to test if the client object works correctly with curl
      * 
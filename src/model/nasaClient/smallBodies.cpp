@@ -0,0 +1,225 @@
+#include "smallBodies.hpp"
+#include "julianDate.hpp"
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <thread>
+
+using std::endl;
+using std::cerr;
+
+//===============================================================================================================
+// Constants Definition
+//===============================================================================================================
+static const double AU = 149597870.7;              // km
+static const double DEG = M_PI / 180.0;
+static const double TWO_PI = 2 * M_PI;
+static const size_t BLOCK = 64;                     // objects per kernel pass, the arrays are padded to it
+static const int NEWTON_STEPS = 5;                  // enough for e < 0.98 from Danby's starting value
+static const float TWO_OVER_PI = 0.636619772f;
+static const float PI_OVER_2_HI = 1.5703125f;       // pi / 2 split so q * PI_OVER_2_HI is exact
+static const float PI_OVER_2_LO = 4.83826794897e-4f;
+
+//===============================================================================================================
+// Helper Function Definition
+//===============================================================================================================
+static bool readField(const char *line, size_t length, size_t column, size_t width, double &value);
+static bool readPackedEpoch(const char *packed, double &jd);
+static inline void sinCos(float x, float &s, float &c);
+
+//===============================================================================================================
+// SmallBodies Class
+//...............................................................................................................
+// Constructor
+//...............................................................................................................
+SmallBodies::SmallBodies() {
+    this->count = 0;
+    this->threads = 0;
+}
+
+//...............................................................................................................
+// Public Methods
+//...............................................................................................................
+bool SmallBodies::load(std::string path, size_t limit) {
+    FILE *file = fopen(path.c_str(), "r");
+    if (file == NULL) {
+        cerr << "Unable to read small body orbits from " << path << endl;
+        return false;
+    }
+
+    // Fixed columns of MPCORB.DAT, header and comment lines fail to parse and are skipped
+    this->count = 0;
+    for (std::vector<double> *column : {&this->epoch, &this->meanAnomaly, &this->meanMotion})
+        column->clear();
+    for (std::vector<float> *column : {&this->eccentricity, &this->px, &this->py, &this->pz, &this->qx, &this->qy, &this->qz})
+        column->clear();
+    char line[256];
+    while (fgets(line, sizeof(line), file) != NULL && (limit == 0 || this->count < limit)) {
+        size_t length = strlen(line);
+        double epoch, m, peri, node, incl, e, n, a;
+        if (length < 103 || !readPackedEpoch(line + 20, epoch) ||
+            !readField(line, length, 27, 9, m) || !readField(line, length, 38, 9, peri) ||
+            !readField(line, length, 49, 9, node) || !readField(line, length, 60, 9, incl) ||
+            !readField(line, length, 71, 9, e) || !readField(line, length, 81, 11, n) ||
+            !readField(line, length, 93, 11, a))
+            continue;
+        if (e < 0 || e >= 1 || a <= 0 || n <= 0)
+            continue;
+        this->addOrbit(epoch, m, peri, node, incl, e, n, a);
+    }
+    fclose(file);
+
+    // Pad to whole blocks with orbits of zero size, they sit on the Sun and are never drawn
+    size_t padded = (this->count + BLOCK - 1) / BLOCK * BLOCK;
+    for (std::vector<double> *column : {&this->epoch, &this->meanAnomaly, &this->meanMotion})
+        column->resize(padded, 0);
+    for (std::vector<float> *column : {&this->eccentricity, &this->px, &this->py, &this->pz, &this->qx, &this->qy, &this->qz})
+        column->resize(padded, 0);
+    this->points.resize(3 * padded, 0);
+    return true;
+}
+
+size_t SmallBodies::size() {
+    return this->count;
+}
+
+void SmallBodies::setThreads(unsigned threads) {
+    this->threads = threads;
+}
+
+void SmallBodies::update(double jd, const double sunPos[3]) {
+    size_t blocks = this->eccentricity.size() / BLOCK;
+    if (blocks == 0)
+        return;
+
+    // Whole blocks per thread, the calling thread takes the first share
+    unsigned threads = (this->threads > 0) ? this->threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = (unsigned)std::min<size_t>(threads, blocks);
+    size_t share = (blocks + threads - 1) / threads;
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < threads; t++) {
+        size_t begin = std::min(blocks, t * share) * BLOCK;
+        size_t end = std::min(blocks, (t + 1) * share) * BLOCK;
+        if (begin < end)
+            workers.emplace_back(&SmallBodies::place, this, begin, end, jd, sunPos);
+    }
+    this->place(0, std::min(blocks, share) * BLOCK, jd, sunPos);
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+const float *SmallBodies::getPoints() {
+    return this->points.data();
+}
+
+//...............................................................................................................
+// Private Methods
+//...............................................................................................................
+void SmallBodies::addOrbit(double epoch, double m, double peri, double node, double incl, double e, double n, double a) {
+    double cosPeri = cos(peri * DEG), sinPeri = sin(peri * DEG);
+    double cosNode = cos(node * DEG), sinNode = sin(node * DEG);
+    double cosIncl = cos(incl * DEG), sinIncl = sin(incl * DEG);
+    double size = a * AU;
+    double minor = size * sqrt(1 - e * e);
+
+    this->epoch.push_back(epoch);
+    this->meanAnomaly.push_back(m * DEG);
+    this->meanMotion.push_back(n * DEG);
+    this->eccentricity.push_back(e);
+    this->px.push_back(size * (cosPeri * cosNode - sinPeri * sinNode * cosIncl));
+    this->py.push_back(size * (cosPeri * sinNode + sinPeri * cosNode * cosIncl));
+    this->pz.push_back(size * (sinPeri * sinIncl));
+    this->qx.push_back(minor * (-sinPeri * cosNode - cosPeri * sinNode * cosIncl));
+    this->qy.push_back(minor * (-sinPeri * sinNode + cosPeri * cosNode * cosIncl));
+    this->qz.push_back(minor * (cosPeri * sinIncl));
+    this->count++;
+}
+
+void SmallBodies::place(size_t begin, size_t end, double jd, const double sunPos[3]) {
+    float sunX = sunPos[0], sunY = sunPos[1], sunZ = sunPos[2];
+    for (size_t block = begin; block < end; block += BLOCK) {
+        const double *epoch = &this->epoch[block];
+        const double *m0 = &this->meanAnomaly[block];
+        const double *n = &this->meanMotion[block];
+        const float *e = &this->eccentricity[block];
+        float *points = &this->points[3 * block];
+        float m[BLOCK], anomaly[BLOCK];
+
+        // Mean anomaly in double precision, wrapped to [-pi, pi] before the single precision solve
+        for (size_t i = 0; i < BLOCK; i++) {
+            double mean = m0[i] + n[i] * (jd - epoch[i]);
+            mean -= TWO_PI * (double)(int)(mean * (1 / TWO_PI));
+            mean += (mean > M_PI) ? -TWO_PI : ((mean < -M_PI) ? TWO_PI : 0);
+            m[i] = (float)mean;
+        }
+
+        // Kepler's equation E - e sin E = M, Newton steps from E = M + 0.85 e sign(M)
+        for (size_t i = 0; i < BLOCK; i++)
+            anomaly[i] = m[i] + ((m[i] >= 0) ? 0.85f : -0.85f) * e[i];
+        for (int step = 0; step < NEWTON_STEPS; step++) {
+            for (size_t i = 0; i < BLOCK; i++) {
+                float s, c;
+                sinCos(anomaly[i], s, c);
+                anomaly[i] -= (anomaly[i] - e[i] * s - m[i]) / (1 - e[i] * c);
+            }
+        }
+
+        for (size_t i = 0; i < BLOCK; i++) {
+            float s, c;
+            sinCos(anomaly[i], s, c);
+            float along = c - e[i];
+            points[3 * i] = sunX + along * this->px[block + i] + s * this->qx[block + i];
+            points[3 * i + 1] = sunY + along * this->py[block + i] + s * this->qy[block + i];
+            points[3 * i + 2] = sunZ + along * this->pz[block + i] + s * this->qz[block + i];
+        }
+    }
+}
+
+//===============================================================================================================
+// Helper Functions
+//===============================================================================================================
+static bool readField(const char *line, size_t length, size_t column, size_t width, double &value) {
+    // Columns are 1-based as in the MPC format description
+    if (column - 1 + width > length)
+        return false;
+    char field[32];
+    memcpy(field, line + column - 1, width);
+    field[width] = '\0';
+    char *end;
+    value = strtod(field, &end);
+    while (*end == ' ')
+        end++;
+    return end != field && *end == '\0';
+}
+
+static bool readPackedEpoch(const char *packed, double &jd) {
+    // e.g. K2555: century letter, two digit year, month and day as 1-9 then A-V
+    auto decode = [](char c) { return (c >= '1' && c <= '9') ? c - '0' : ((c >= 'A' && c <= 'V') ? c - 'A' + 10 : 0); };
+    if (packed[0] < 'I' || packed[0] > 'K' || packed[1] < '0' || packed[1] > '9' || packed[2] < '0' || packed[2] > '9')
+        return false;
+    CalendarDate date;
+    date.year = 100 * (packed[0] - 'I' + 18) + 10 * (packed[1] - '0') + (packed[2] - '0');
+    date.month = decode(packed[3]);
+    date.day = decode(packed[4]);
+    if (date.month < 1 || date.month > 12 || date.day < 1)
+        return false;
+    jd = julian::fromCalendar(date);
+    return true;
+}
+
+static inline void sinCos(float x, float &s, float &c) {
+    // Quadrant reduction to [-pi/4, pi/4] and Taylor polynomials, branch free so the loops vectorize
+    int q = (int)(x * TWO_OVER_PI + ((x >= 0) ? 0.5f : -0.5f));
+    float r = (x - q * PI_OVER_2_HI) - q * PI_OVER_2_LO;
+    float r2 = r * r;
+    float sr = r + r * r2 * (-1.0f / 6 + r2 * (1.0f / 120 + r2 * (-1.0f / 5040)));
+    float cr = 1 + r2 * (-0.5f + r2 * (1.0f / 24 + r2 * (-1.0f / 720 + r2 * (1.0f / 40320))));
+    float sv = (q & 1) ? cr : sr;
+    float cv = (q & 1) ? sr : cr;
+    s = (q & 2) ? -sv : sv;
+    c = ((q + 1) & 2) ? -cv : cv;
+}
@@ -0,0 +1,65 @@
+#ifndef SmallBodies_h
+#define SmallBodies_h
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Asteroids and trans-Neptunian objects from a Minor Planet Center orbit file (MPCORB.DAT layout),
+ * placed on their osculating Keplerian orbits around the Sun and drawn as a point cloud.
+ * Elements are kept as one array per quantity, with each orbit's perifocal axes already scaled by its size,
+ * and every date change solves Kepler's equation for all objects in fixed width blocks split across threads.
+ * The solver runs in single precision with a fixed number of Newton steps, which is far below a pixel at
+ * solar system scale.
+ *
+ */
+class SmallBodies {
+private:
+    size_t count;
+    std::vector<double> epoch;          // Julian date of the elements
+    std::vector<double> meanAnomaly;    // at the epoch (rad)
+    std::vector<double> meanMotion;     // rad/day
+    std::vector<float> eccentricity;
+    std::vector<float> px, py, pz;      // a * P, towards perihelion (km)
+    std::vector<float> qx, qy, qz;      // a * sqrt(1 - e^2) * Q
+    std::vector<float> points;          // x, y, z per object, geocentric (km)
+    unsigned threads;
+
+    void addOrbit(double epoch, double m, double peri, double node, double incl, double e, double n, double a);
+    void place(size_t begin, size_t end, double jd, const double sunPos[3]);
+
+public:
+    SmallBodies();
+
+    /**
+     * @brief Read the orbits of an MPCORB.DAT style file, skipping its header and unbound orbits
+     *
+     * @param limit read at most this many objects, 0 for all of them
+     * @return false if the file cannot be read
+     */
+    bool load(std::string path, size_t limit=0);
+
+    size_t size();
+
+    /**
+     * @brief Set the number of threads sharing an update, 0 uses every core
+     *
+     */
+    void setThreads(unsigned threads);
+
+    /**
+     * @brief Place every object at a Julian date
+     *
+     * @param sunPos geocentric position of the Sun at the date (km)
+     */
+    void update(double jd, const double sunPos[3]);
+
+    /**
+     * @brief Positions of the last update, 3 floats per object, ready for a vertex array
+     *
+     */
+    const float *getPoints();
+};
+
+#endif
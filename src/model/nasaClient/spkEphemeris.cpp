@@ -0,0 +1,322 @@
+#include "spkEphemeris.hpp"
+
+#include <iostream>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+#include <memory>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using std::endl;
+using std::cerr;
+
+//===============================================================================================================
+// Constants Definition
+//===============================================================================================================
+static const size_t DAF_RECORD_SIZE = 1024;
+static const long SPK_ND = 2;               // doubles per summary: start and end epochs
+static const long SPK_NI = 6;               // integers per summary: target, center, frame, type, begin, end
+static const int FRAME_J2000 = 1;
+static const int FRAME_ECLIPJ2000 = 17;
+static const long SOLAR_SYSTEM_BARYCENTER = 0;
+static const long EARTH = 399;
+static const int MAX_CHAIN_LENGTH = 8;
+static const double J2000 = 2451545.0;
+static const double SECONDS_PER_DAY = 86400.0;
+static const double OBLIQUITY_J2000 = 84381.448 / 3600.0 * M_PI / 180.0;    // IAU 1976, as used by Horizons
+
+//===============================================================================================================
+// Helper Function Definition
+//===============================================================================================================
+static void toEcliptic(double pos[3]);
+
+//===============================================================================================================
+// SpkEphemeris Class
+//...............................................................................................................
+// Constructor and Destructor
+//...............................................................................................................
+SpkEphemeris::SpkEphemeris(std::string path) {
+    this->path = path;
+    this->fd = -1;
+    this->mappedSize = 0;
+    this->mapped = NULL;
+    if (!this->open())
+        cerr << "SPK kernel disabled, unable to read " << path << endl;
+}
+
+SpkEphemeris::~SpkEphemeris() {
+    this->close();
+}
+
+//...............................................................................................................
+// Public Methods
+//...............................................................................................................
+bool SpkEphemeris::isOpen() {
+    return this->mapped != NULL;
+}
+
+bool SpkEphemeris::covers(long index, double jd) {
+    double et = (jd - J2000) * SECONDS_PER_DAY;
+    for (long target : {this->resolve(index), (long)EARTH}) {
+        while (target != SOLAR_SYSTEM_BARYCENTER) {
+            const Segment *segment = this->findSegment(target, et);
+            if (segment == NULL)
+                return false;
+            target = segment->center;
+        }
+    }
+    return true;
+}
+
+bool SpkEphemeris::getPos(long index, double jd, double pos[3]) {
+    bool valid;
+    this->getPositions(&index, 1, &jd, 1, pos, &valid);
+    return valid;
+}
+
+void SpkEphemeris::getPositions(const long *indices, size_t n, const double *jd, size_t epochs, double *pos, bool *valid) {
+    std::vector<double> et(epochs);
+    for (size_t e = 0; e < epochs; e++)
+        et[e] = (jd[e] - J2000) * SECONDS_PER_DAY;
+
+    // Barycentric Earth once for all bodies
+    std::vector<double> earth(3 * epochs, 0.0);
+    std::unique_ptr<bool[]> earthValid(new bool[epochs]);
+    std::fill(earthValid.get(), earthValid.get() + epochs, this->isOpen());
+    this->addChain(EARTH, et.data(), epochs, earth.data(), earthValid.get());
+
+    std::vector<double> body(3 * epochs);
+    std::unique_ptr<bool[]> bodyValid(new bool[epochs]);
+    for (size_t i = 0; i < n; i++) {
+        long target = this->resolve(indices[i]);
+        std::fill(body.begin(), body.end(), 0.0);
+        std::copy(earthValid.get(), earthValid.get() + epochs, bodyValid.get());
+        if (target != EARTH)
+            this->addChain(target, et.data(), epochs, body.data(), bodyValid.get());
+
+        for (size_t e = 0; e < epochs; e++) {
+            double *out = &pos[3 * (e * n + i)];
+            valid[e * n + i] = bodyValid[e];
+            if (target == EARTH) {
+                out[0] = out[1] = out[2] = 0;
+                continue;
+            }
+            for (int k = 0; k < 3; k++)
+                out[k] = body[3 * e + k] - earth[3 * e + k];
+        }
+    }
+}
+
+//...............................................................................................................
+// Private Methods
+//...............................................................................................................
+bool SpkEphemeris::open() {
+    this->fd = ::open(this->path.c_str(), O_RDONLY);
+    if (this->fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(this->fd, &info) != 0 || (size_t)info.st_size < DAF_RECORD_SIZE) {
+        this->close();
+        return false;
+    }
+
+    void *mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, this->fd, 0);
+    if (mapped == MAP_FAILED) {
+        this->close();
+        return false;
+    }
+    this->mapped = (const char *)mapped;
+    this->mappedSize = info.st_size;
+
+    // File record: LOCIDW, ND, NI, LOCIFN, FWARD, BWARD, FREE, LOCFMT
+    int32_t nd, ni, forward;
+    memcpy(&nd, this->mapped + 8, sizeof(nd));
+    memcpy(&ni, this->mapped + 12, sizeof(ni));
+    memcpy(&forward, this->mapped + 76, sizeof(forward));
+    bool spk = memcmp(this->mapped, "DAF/SPK ", 8) == 0 || memcmp(this->mapped, "NAIF/DAF", 8) == 0;
+    bool bigEndian = memcmp(this->mapped + 88, "BIG-IEEE", 8) == 0;
+    if (!spk || bigEndian || nd != SPK_ND || ni != SPK_NI || !this->readSummaries(nd, ni, forward)) {
+        cerr << path << " is not a little-endian SPK kernel" << endl;
+        this->close();
+        return false;
+    }
+    return true;
+}
+
+bool SpkEphemeris::readSummaries(long nd, long ni, long forward) {
+    const double *words = (const double *)this->mapped;
+    size_t wordCount = this->mappedSize / sizeof(double);
+    size_t summarySize = nd + (ni + 1) / 2;
+
+    // Summary records form a doubly linked list: NEXT, PREV, NSUM then the summaries
+    long record = forward;
+    size_t visited = 0;
+    while (record > 0) {
+        size_t offset = (record - 1) * DAF_RECORD_SIZE;
+        if (offset + DAF_RECORD_SIZE > this->mappedSize || ++visited > this->mappedSize / DAF_RECORD_SIZE)
+            return false;
+        const double *summaries = (const double *)(this->mapped + offset);
+        long next = (long)summaries[0];
+        long count = (long)summaries[2];
+        if (count < 0 || 3 + count * summarySize > DAF_RECORD_SIZE / sizeof(double))
+            return false;
+
+        for (long s = 0; s < count; s++) {
+            const double *summary = summaries + 3 + s * summarySize;
+            int32_t ints[SPK_NI];
+            memcpy(ints, summary + nd, sizeof(ints));
+            int type = ints[3];
+            long begin = ints[4];
+            long end = ints[5];
+            if ((type != 2 && type != 3) || (ints[2] != FRAME_J2000 && ints[2] != FRAME_ECLIPJ2000))
+                continue;
+            if (begin < 1 || end < begin + 4 || (size_t)end > wordCount)
+                return false;
+
+            // Chebyshev segment directory at its end: INIT, INTLEN, RSIZE, N (addresses are 1-based)
+            Segment segment;
+            segment.target = ints[0];
+            segment.center = ints[1];
+            segment.frame = ints[2];
+            segment.start = summary[0];
+            segment.end = summary[1];
+            segment.init = words[end - 4];
+            segment.length = words[end - 3];
+            segment.recordSize = (long)words[end - 2];
+            segment.records = (long)words[end - 1];
+            segment.coefficients = (segment.recordSize - 2) / ((type == 2) ? 3 : 6);
+            segment.data = &words[begin - 1];
+            if (segment.length <= 0 || segment.records < 1 || segment.coefficients < 1 ||
+                begin - 1 + segment.recordSize * segment.records > end - 4)
+                return false;
+            this->segments[segment.target].push_back(segment);
+        }
+        record = next;
+    }
+    return true;
+}
+
+void SpkEphemeris::close() {
+    if (this->mapped != NULL)
+        munmap((void *)this->mapped, this->mappedSize);
+    if (this->fd >= 0)
+        ::close(this->fd);
+    this->mapped = NULL;
+    this->fd = -1;
+    this->mappedSize = 0;
+    this->segments.clear();
+}
+
+long SpkEphemeris::resolve(long index) {
+    // Planetary kernels only carry the barycentres of the outer planets, close enough to their centres here
+    if (this->segments.count(index) == 0 && index > 100 && index % 100 == 99 && this->segments.count(index / 100) > 0)
+        return index / 100;
+    return index;
+}
+
+const SpkEphemeris::Segment *SpkEphemeris::findSegment(long target, double et) {
+    auto found = this->segments.find(target);
+    if (found == this->segments.end())
+        return NULL;
+
+    // Later segments take precedence over earlier ones
+    const std::vector<Segment> &candidates = found->second;
+    for (size_t i = candidates.size(); i-- > 0;) {
+        if (et >= candidates[i].start && et <= candidates[i].end)
+            return &candidates[i];
+    }
+    return NULL;
+}
+
+void SpkEphemeris::addChain(long target, const double *et, size_t epochs, double *pos, bool *valid) {
+    std::vector<const double *> coefficients(epochs);
+    std::vector<long> count(epochs);
+    std::vector<char> ecliptic(epochs);
+    std::vector<double> s(epochs);
+    std::vector<double> b1(3 * epochs), b2(3 * epochs);
+    std::vector<long> center(epochs, target);
+
+    // Walk every date one link down its chain per pass until all of them reach the barycentre
+    for (int pass = 0; pass < MAX_CHAIN_LENGTH; pass++) {
+        long maxCount = 0;
+        for (size_t e = 0; e < epochs; e++) {
+            coefficients[e] = NULL;
+            if (!valid[e] || center[e] == SOLAR_SYSTEM_BARYCENTER)
+                continue;
+            const Segment *segment = this->findSegment(center[e], et[e]);
+            if (segment == NULL) {
+                valid[e] = false;
+                continue;
+            }
+
+            long record = (long)floor((et[e] - segment->init) / segment->length);
+            if (record < 0)
+                record = 0;
+            if (record >= segment->records)
+                record = segment->records - 1;
+            const double *data = segment->data + record * segment->recordSize;
+            s[e] = (et[e] - data[0]) / data[1];     // MID and RADIUS of the record
+            coefficients[e] = data + 2;
+            count[e] = segment->coefficients;
+            ecliptic[e] = segment->frame == FRAME_ECLIPJ2000;
+            center[e] = segment->center;
+            if (count[e] > maxCount)
+                maxCount = count[e];
+        }
+        if (maxCount == 0)
+            break;
+
+        // Clenshaw recurrence across dates, highest coefficient first
+        std::fill(b1.begin(), b1.end(), 0.0);
+        std::fill(b2.begin(), b2.end(), 0.0);
+        for (long k = maxCount - 1; k >= 1; k--) {
+            for (size_t e = 0; e < epochs; e++) {
+                if (coefficients[e] == NULL || k >= count[e])
+                    continue;
+                for (int c = 0; c < 3; c++) {
+                    double b0 = coefficients[e][c * count[e] + k] + 2 * s[e] * b1[3 * e + c] - b2[3 * e + c];
+                    b2[3 * e + c] = b1[3 * e + c];
+                    b1[3 * e + c] = b0;
+                }
+            }
+        }
+        for (size_t e = 0; e < epochs; e++) {
+            if (coefficients[e] == NULL)
+                continue;
+            double link[3];
+            for (int c = 0; c < 3; c++)
+                link[c] = coefficients[e][c * count[e]] + s[e] * b1[3 * e + c] - b2[3 * e + c];
+
+            // Links given in the ecliptic frame are rotated back so the chain adds up in J2000
+            if (ecliptic[e]) {
+                double y = link[1], z = link[2];
+                link[1] = cos(OBLIQUITY_J2000) * y - sin(OBLIQUITY_J2000) * z;
+                link[2] = sin(OBLIQUITY_J2000) * y + cos(OBLIQUITY_J2000) * z;
+            }
+            for (int c = 0; c < 3; c++)
+                pos[3 * e + c] += link[c];
+        }
+    }
+
+    // Barycentric J2000 to the ecliptic frame of the Horizons data
+    for (size_t e = 0; e < epochs; e++) {
+        if (center[e] != SOLAR_SYSTEM_BARYCENTER)
+            valid[e] = false;
+        if (valid[e])
+            toEcliptic(&pos[3 * e]);
+    }
+}
+
+//===============================================================================================================
+// Helper Functions
+//===============================================================================================================
+static void toEcliptic(double pos[3]) {
+    double y = pos[1], z = pos[2];
+    pos[1] = cos(OBLIQUITY_J2000) * y + sin(OBLIQUITY_J2000) * z;
+    pos[2] = -sin(OBLIQUITY_J2000) * y + cos(OBLIQUITY_J2000) * z;
+}
@@ -0,0 +1,82 @@
+#ifndef SpkEphemeris_h
+#define SpkEphemeris_h
+
+#include <stddef.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief JPL planetary ephemeris read from a binary SPK kernel (e.g. de440s.bsp), in the frame the Horizons
+ * data uses (geocentric, ecliptic J2000, km).
+ * The kernel's DAF file is memory-mapped and its segment summaries are indexed by target when it is opened.
+ * Chebyshev position segments (SPK types 2 and 3, J2000 or ECLIPJ2000 frame) are evaluated straight from the
+ * mapping, a body's position being the sum of its segment chain down to the solar system barycentre.
+ * Only little-endian kernels are read.
+ *
+ */
+class SpkEphemeris {
+private:
+    struct Segment {
+        long target;
+        long center;
+        int frame;
+        double start;           // coverage (TDB seconds past J2000)
+        double end;
+        double init;            // start of the first record
+        double length;          // interval covered by each record (s)
+        long recordSize;        // doubles per record
+        long records;
+        long coefficients;      // Chebyshev coefficients per component
+        const double *data;     // first record, inside the mapping
+    };
+
+    std::string path;
+    int fd;
+    size_t mappedSize;
+    const char *mapped;
+    std::unordered_map<long, std::vector<Segment>> segments;   // by target, in file order
+
+    bool open();
+    void close();
+    bool readSummaries(long nd, long ni, long forward);
+    long resolve(long index);
+    const Segment *findSegment(long target, double et);
+    void addChain(long target, const double *et, size_t epochs, double *pos, bool *valid);
+
+public:
+    /**
+     * @brief Map the kernel at the given path, the ephemeris is empty if it cannot be read
+     *
+     */
+    SpkEphemeris(std::string path);
+    ~SpkEphemeris();
+
+    bool isOpen();
+
+    /**
+     * @brief Check if a body (Horizons index) and the Earth are covered at a Julian date (TDB)
+     *
+     */
+    bool covers(long index, double jd);
+
+    /**
+     * @brief Geocentric position of a body at a Julian date (km)
+     *
+     * @return false if the body is not covered at the date
+     */
+    bool getPos(long index, double jd, double pos[3]);
+
+    /**
+     * @brief Geocentric positions of several bodies at several dates. Each segment link is evaluated for
+     * every date in one pass, the Chebyshev recurrences running across dates.
+     *
+     * @param indices n Horizons body indices
+     * @param jd Julian dates (TDB)
+     * @param pos output, epochs * n * 3 positions (km), date major
+     * @param valid output, epochs * n flags
+     */
+    void getPositions(const long *indices, size_t n, const double *jd, size_t epochs, double *pos, bool *valid);
+};
+
+#endif
@@ -0,0 +1,220 @@
+#include "trajectory.hpp"
+
+#include <algorithm>
+#include <math.h>
+
+//===============================================================================================================
+// Trajectory Class
+//...............................................................................................................
+// Constructor
+//...............................................................................................................
+Trajectory::Trajectory() {
+    this->radius = 0;
+}
+
+//...............................................................................................................
+// Public Methods
+//...............................................................................................................
+void Trajectory::clear() {
+    this->jd.clear();
+    this->x.clear();
+    this->y.clear();
+    this->z.clear();
+    this->vx.clear();
+    this->vy.clear();
+    this->vz.clear();
+}
+
+void Trajectory::reserve(size_t n) {
+    this->jd.reserve(n);
+    this->x.reserve(n);
+    this->y.reserve(n);
+    this->z.reserve(n);
+    this->vx.reserve(n);
+    this->vy.reserve(n);
+    this->vz.reserve(n);
+}
+
+void Trajectory::addSample(double jd, double x, double y, double z, double vx, double vy, double vz) {
+    this->jd.push_back(jd);
+    this->x.push_back(x);
+    this->y.push_back(y);
+    this->z.push_back(z);
+    this->vx.push_back(vx);
+    this->vy.push_back(vy);
+    this->vz.push_back(vz);
+}
+
+void Trajectory::setRadius(float radius) {
+    this->radius = radius;
+}
+
+float Trajectory::getRadius() {
+    return this->radius;
+}
+
+size_t Trajectory::size() {
+    return this->jd.size();
+}
+
+double Trajectory::getStart() {
+    return this->jd.empty() ? 0 : this->jd.front();
+}
+
+double Trajectory::getEnd() {
+    return this->jd.empty() ? 0 : this->jd.back();
+}
+
+bool Trajectory::contains(double jd) {
+    return this->indexOf(jd) >= 0;
+}
+
+bool Trajectory::getPos(double jd, double pos[3]) {
+    long i = this->indexOf(jd);
+    if (i < 0)
+        return false;
+    pos[0] = this->x[i];
+    pos[1] = this->y[i];
+    pos[2] = this->z[i];
+    return true;
+}
+
+bool Trajectory::getState(double jd, double pos[3], double vel[3]) {
+    long i = this->indexOf(jd);
+    if (i < 0)
+        return false;
+    pos[0] = this->x[i];
+    pos[1] = this->y[i];
+    pos[2] = this->z[i];
+    vel[0] = this->vx[i];
+    vel[1] = this->vy[i];
+    vel[2] = this->vz[i];
+    return true;
+}
+
+double Trajectory::getSampleDate(size_t i) {
+    return this->jd[i];
+}
+
+bool Trajectory::interpolate(double jd, double pos[3], double *error) {
+    Trajectory *self = this;
+    bool valid;
+    double estimate;
+    interpolateTrajectories(&self, 1, jd, pos, &estimate, &valid);
+    if (error != NULL)
+        *error = estimate;
+    return valid;
+}
+
+//...............................................................................................................
+// Private Methods
+//...............................................................................................................
+long Trajectory::indexOf(double jd) {
+    size_t n = this->jd.size();
+    if (n == 0 || jd < this->jd.front() || jd > this->jd.back())
+        return -1;
+
+    // Samples are normally evenly spaced, so try the direct index before searching
+    if (n > 1) {
+        double step = (this->jd.back() - this->jd.front()) / (n - 1);
+        long guess = lround((jd - this->jd.front()) / step);
+        if (guess >= 0 && (size_t)guess < n && this->jd[guess] == jd)
+            return guess;
+    }
+    auto it = std::lower_bound(this->jd.begin(), this->jd.end(), jd);
+    if (it == this->jd.end() || *it != jd)
+        return -1;
+    return it - this->jd.begin();
+}
+
+long Trajectory::intervalOf(double jd) {
+    size_t n = this->jd.size();
+    if (n < 2 || jd < this->jd.front() || jd > this->jd.back())
+        return -1;
+
+    double step = (this->jd.back() - this->jd.front()) / (n - 1);
+    long i = (long)((jd - this->jd.front()) / step);
+    if (i >= (long)n - 1)
+        i = n - 2;
+    if (this->jd[i] <= jd && jd <= this->jd[i + 1])
+        return i;
+    auto it = std::upper_bound(this->jd.begin(), this->jd.end(), jd);
+    i = (it - this->jd.begin()) - 1;
+    return (i >= (long)n - 1) ? n - 2 : i;
+}
+
+//===============================================================================================================
+// Helper Functions
+//===============================================================================================================
+void interpolateTrajectories(Trajectory *const *trajectories, size_t n, double jd, double *pos, double *error, bool *valid) {
+    const double SECONDS_PER_DAY = 86400.0;
+
+    // Gather the bracketing samples of every body into contiguous arrays (3 components per body)
+    std::vector<double> s(n), p0(3 * n), p1(3 * n), m0(3 * n), m1(3 * n), a3(3 * n), a3Next(3 * n);
+    std::vector<bool> hasNeighbour(n, false);
+    for (size_t b = 0; b < n; b++) {
+        Trajectory &t = *trajectories[b];
+        long i = t.intervalOf(jd);
+        valid[b] = i >= 0;
+        if (!valid[b]) {
+            s[b] = 0;
+            for (int c = 0; c < 3; c++)
+                p0[3 * b + c] = p1[3 * b + c] = m0[3 * b + c] = m1[3 * b + c] = a3[3 * b + c] = a3Next[3 * b + c] = 0;
+            continue;
+        }
+        double h = t.jd[i + 1] - t.jd[i];
+        double scale = h * SECONDS_PER_DAY;     // km/s to km per unit interval
+        s[b] = (jd - t.jd[i]) / h;
+
+        const std::vector<double> *position[3] = {&t.x, &t.y, &t.z};
+        const std::vector<double> *velocity[3] = {&t.vx, &t.vy, &t.vz};
+        // The neighbouring interval used for the error estimate, after the current one if possible
+        long k = (i + 2 < (long)t.jd.size()) ? i + 1 : i - 1;
+        hasNeighbour[b] = k >= 0;
+        double hk = hasNeighbour[b] ? (t.jd[k + 1] - t.jd[k]) * SECONDS_PER_DAY : 0;
+        for (int c = 0; c < 3; c++) {
+            const std::vector<double> &pc = *position[c];
+            const std::vector<double> &vc = *velocity[c];
+            p0[3 * b + c] = pc[i];
+            p1[3 * b + c] = pc[i + 1];
+            m0[3 * b + c] = vc[i] * scale;
+            m1[3 * b + c] = vc[i + 1] * scale;
+            // Cubic coefficient of the Hermite polynomial, in units of this interval
+            a3[3 * b + c] = 2 * pc[i] + m0[3 * b + c] - 2 * pc[i + 1] + m1[3 * b + c];
+            if (hasNeighbour[b]) {
+                double ratio = scale / hk;  // rescale the neighbour's cubic term to this interval's length
+                a3Next[3 * b + c] = (2 * pc[k] + vc[k] * hk - 2 * pc[k + 1] + vc[k + 1] * hk) * ratio * ratio * ratio;
+            } else {
+                a3Next[3 * b + c] = a3[3 * b + c];
+            }
+        }
+    }
+
+    // Evaluate the Hermite basis for all bodies at once
+    size_t count = 3 * n;
+    for (size_t j = 0; j < count; j++) {
+        double t = s[j / 3];
+        double t2 = t * t;
+        double t3 = t2 * t;
+        double h00 = 2 * t3 - 3 * t2 + 1;
+        double h10 = t3 - 2 * t2 + t;
+        double h01 = -2 * t3 + 3 * t2;
+        double h11 = t3 - t2;
+        pos[j] = h00 * p0[j] + h10 * m0[j] + h01 * p1[j] + h11 * m1[j];
+    }
+
+    // Hermite error is s^2 (1-s)^2 / 24 * f4, with the 4th derivative f4 (in interval units) ~ 6 * change of the cubic term
+    if (error != NULL) {
+        for (size_t b = 0; b < n; b++) {
+            if (!valid[b] || !hasNeighbour[b]) {
+                error[b] = -1;
+                continue;
+            }
+            double dx = a3Next[3 * b] - a3[3 * b];
+            double dy = a3Next[3 * b + 1] - a3[3 * b + 1];
+            double dz = a3Next[3 * b + 2] - a3[3 * b + 2];
+            double w = s[b] * s[b] * (1 - s[b]) * (1 - s[b]) / 4;
+            error[b] = w * sqrt(dx * dx + dy * dy + dz * dz);
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef Trajectory_h
+#define Trajectory_h
+
+#include <stddef.h>
+#include <vector>
+
+/**
+ * @brief Time series of Horizons state vectors for one body.
+ * Samples are kept sorted by Julian date in contiguous per-component arrays.
+ * Positions are in km and velocities in km/s, as returned by Horizons.
+ *
+ */
+class Trajectory {
+private:
+    std::vector<double> jd;
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> z;
+    std::vector<double> vx;
+    std::vector<double> vy;
+    std::vector<double> vz;
+    float radius;
+
+    long indexOf(double jd);
+    long intervalOf(double jd);
+
+    friend void interpolateTrajectories(Trajectory *const *trajectories, size_t n, double jd, double *pos, double *error, bool *valid);
+
+public:
+    Trajectory();
+
+    void clear();
+    void reserve(size_t n);
+
+    /**
+     * @brief Append a sample, samples must be added in increasing date order
+     *
+     */
+    void addSample(double jd, double x, double y, double z, double vx, double vy, double vz);
+    void setRadius(float radius);
+    float getRadius();
+
+    size_t size();
+    double getStart();
+    double getEnd();
+
+    /**
+     * @brief Check if the trajectory has a sample at the given date
+     *
+     */
+    bool contains(double jd);
+
+    /**
+     * @brief Get the position of the sample at the given date
+     *
+     * @return false if there is no sample at the date
+     */
+    bool getPos(double jd, double pos[3]);
+
+    /**
+     * @brief Get the position and velocity (km/s) of the sample at the given date
+     *
+     * @return false if there is no sample at the date
+     */
+    bool getState(double jd, double pos[3], double vel[3]);
+
+    /**
+     * @brief Date of the i-th sample
+     *
+     */
+    double getSampleDate(size_t i);
+
+    /**
+     * @brief Get the position at any date between the first and last sample using cubic Hermite
+     * interpolation of the bracketing samples' positions and velocities
+     *
+     * @param error estimated interpolation error (km), from the change of the cubic term between
+     * neighbouring intervals. Negative if there are not enough samples to estimate it.
+     * @return false if the date is outside the trajectory
+     */
+    bool interpolate(double jd, double pos[3], double *error = NULL);
+};
+
+/**
+ * @brief Interpolate several trajectories at the same date in one pass.
+ * Intervals are located per body, then the Hermite basis is evaluated across all bodies at once.
+ *
+ * @param trajectories n trajectories
+ * @param jd Julian date
+ * @param pos output, 3 * n positions (km)
+ * @param error output, n error estimates (km), may be NULL
+ * @param valid output, n flags set to false for trajectories that do not cover the date
+ */
+void interpolateTrajectories(Trajectory *const *trajectories, size_t n, double jd, double *pos, double *error, bool *valid);
+
+#endif
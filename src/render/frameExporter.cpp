@@ -0,0 +1,201 @@
+#include "frameExporter.hpp"
+#include "glResources.hpp"
+#include "../Bmp.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string.h>
+
+//===============================================================================================================
+// FrameExporter Class
+//...............................................................................................................
+// Constructor
+//...............................................................................................................
+FrameExporter::FrameExporter() {
+    this->width = this->height = 0;
+    this->frameSize = 0;
+    this->asyncReadback = false;
+    for (size_t s = 0; s < SLOTS; s++) {
+        this->buffers[s] = 0;
+        this->slots[s].pending = false;
+    }
+    this->submitted = 0;
+    this->queueDepth = 1;
+    this->stopping = false;
+    this->written = 0;
+    this->failures = 0;
+    this->stallSeconds = 0;
+}
+
+FrameExporter::~FrameExporter() {
+    this->finish();
+}
+
+//...............................................................................................................
+// Public Methods
+//...............................................................................................................
+void FrameExporter::init(int width, int height, size_t writerCount, size_t queueDepth) {
+    this->width = width;
+    this->height = height;
+    this->frameSize = (size_t)width * height * 3;
+    this->queueDepth = (queueDepth > 0) ? queueDepth : 1;
+    this->submitted = 0;
+    this->stopping = false;
+#ifdef RENDER_SHADERS_SUPPORTED
+    if (render::hasVersion(2, 1)) {
+        glGenBuffers(SLOTS, this->buffers);
+        for (size_t s = 0; s < SLOTS; s++) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, this->buffers[s]);
+            glBufferData(GL_PIXEL_PACK_BUFFER, this->frameSize, NULL, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        this->asyncReadback = true;
+    }
+#endif
+    for (size_t w = 0; w < std::max(writerCount, (size_t)1); w++)
+        this->writers.push_back(std::thread(&FrameExporter::runWriter, this));
+}
+
+bool FrameExporter::hasAsyncReadback() {
+    return this->asyncReadback;
+}
+
+void FrameExporter::submit(const std::string &path) {
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+#ifdef RENDER_SHADERS_SUPPORTED
+    if (this->asyncReadback) {
+        // The slot read SLOTS frames ago is finished by now, hand it over before reusing its buffer
+        size_t index = this->submitted % SLOTS;
+        Slot &slot = this->slots[index];
+        if (slot.pending)
+            this->collect(slot, this->buffers[index]);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, this->buffers[index]);
+        glReadPixels(0, 0, this->width, this->height, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        slot.path = path;
+        slot.pending = true;
+        this->submitted++;
+        return;
+    }
+#endif
+    std::vector<unsigned char> pixels = this->acquirePixels();
+    glReadPixels(0, 0, this->width, this->height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+    this->enqueue(path, pixels);
+    this->submitted++;
+}
+
+size_t FrameExporter::finish() {
+#ifdef RENDER_SHADERS_SUPPORTED
+    // Oldest first, so the files are queued in submission order
+    for (size_t s = 0; s < SLOTS; s++) {
+        size_t index = (this->submitted + s) % SLOTS;
+        if (this->slots[index].pending)
+            this->collect(this->slots[index], this->buffers[index]);
+    }
+    if (this->asyncReadback)
+        glDeleteBuffers(SLOTS, this->buffers);
+    for (size_t s = 0; s < SLOTS; s++)
+        this->buffers[s] = 0;
+#endif
+    this->asyncReadback = false;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->changed.notify_all();
+    for (std::thread &writer : this->writers)
+        writer.join();
+    this->writers.clear();
+    this->freePixels.clear();
+    return this->written;
+}
+
+size_t FrameExporter::getFailureCount() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->failures;
+}
+
+double FrameExporter::getStallSeconds() {
+    return this->stallSeconds;
+}
+
+//...............................................................................................................
+// Private Methods
+//...............................................................................................................
+std::vector<unsigned char> FrameExporter::acquirePixels() {
+    // Back-pressure: wait for a writer to take a frame when the queue is full
+    std::unique_lock<std::mutex> lock(this->mutex);
+    if (this->jobs.size() >= this->queueDepth) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        this->changed.wait(lock, [this] { return this->jobs.size() < this->queueDepth; });
+        this->stallSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    std::vector<unsigned char> pixels;
+    if (!this->freePixels.empty()) {
+        pixels.swap(this->freePixels.back());
+        this->freePixels.pop_back();
+    }
+    pixels.resize(this->frameSize);
+    return pixels;
+}
+
+void FrameExporter::enqueue(const std::string &path, std::vector<unsigned char> &pixels) {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->jobs.push_back(Job());
+        this->jobs.back().path = path;
+        this->jobs.back().pixels.swap(pixels);
+    }
+    this->changed.notify_all();
+}
+
+void FrameExporter::collect(Slot &slot, unsigned int buffer) {
+#ifdef RENDER_SHADERS_SUPPORTED
+    std::vector<unsigned char> pixels = this->acquirePixels();
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+    const void *mapped = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+    if (mapped != NULL)
+        memcpy(pixels.data(), mapped, this->frameSize);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.pending = false;
+    if (mapped == NULL) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        std::cerr << "Failed to map the pixels of " << slot.path << std::endl;
+        this->failures++;
+        this->freePixels.push_back(std::vector<unsigned char>());
+        this->freePixels.back().swap(pixels);
+        return;
+    }
+    this->enqueue(slot.path, pixels);
+#endif
+}
+
+void FrameExporter::runWriter() {
+    Image::Bmp bmp;
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (true) {
+        this->changed.wait(lock, [this] { return this->stopping || !this->jobs.empty(); });
+        if (this->jobs.empty())
+            return;     // stopping with nothing left
+        Job job;
+        job.path.swap(this->jobs.front().path);
+        job.pixels.swap(this->jobs.front().pixels);
+        this->jobs.pop_front();
+        lock.unlock();
+        this->changed.notify_all();
+
+        // Bottom row first as read, Bmp::save swaps to BGR and pads the rows
+        bool saved = bmp.save(job.path.c_str(), this->width, this->height, 3, job.pixels.data());
+
+        lock.lock();
+        if (saved) {
+            this->written++;
+        } else {
+            this->failures++;
+            std::cerr << "Failed to write " << job.path << ": " << bmp.getError() << std::endl;
+        }
+        this->freePixels.push_back(std::vector<unsigned char>());
+        this->freePixels.back().swap(job.pixels);
+    }
+}
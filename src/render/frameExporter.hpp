@@ -0,0 +1,96 @@
+#ifndef FrameExporter_h
+#define FrameExporter_h
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * @brief Writes rendered frames to BMP files without stalling the render loop.
+ * The framebuffer is read into a ring of pixel pack buffers, so glReadPixels returns at once and a frame is only
+ * mapped SLOTS frames later when the GPU is done with it. Mapped frames are copied into pooled buffers and queued
+ * for a pool of writer threads, which swap the channels and write the files concurrently. The queue is bounded:
+ * when the writers fall behind, submit() waits for them instead of growing without limit.
+ * Without pixel buffer objects the readback is synchronous and only the writing is parallel.
+ *
+ */
+class FrameExporter {
+public:
+    static const size_t SLOTS = 3;          // frames of readback in flight
+
+private:
+    struct Slot {
+        std::string path;
+        bool pending;                       // read into the buffer, not handed to the writers yet
+    };
+
+    struct Job {
+        std::string path;
+        std::vector<unsigned char> pixels;
+    };
+
+    int width;
+    int height;
+    size_t frameSize;                       // bytes of a tightly packed RGB frame
+    bool asyncReadback;
+    unsigned int buffers[SLOTS];            // GL_PIXEL_PACK_BUFFER ring
+    Slot slots[SLOTS];
+    size_t submitted;
+
+    std::vector<std::thread> writers;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<Job> jobs;                   // frames waiting for a writer, at most queueDepth
+    std::vector<std::vector<unsigned char>> freePixels;     // buffers of written frames for reuse
+    size_t queueDepth;
+    bool stopping;
+    size_t written;
+    size_t failures;
+    double stallSeconds;
+
+    std::vector<unsigned char> acquirePixels();
+    void enqueue(const std::string &path, std::vector<unsigned char> &pixels);
+    void collect(Slot &slot, unsigned int buffer);
+    void runWriter();
+
+public:
+    FrameExporter();
+    ~FrameExporter();
+
+    /**
+     * @brief Create the pixel buffers if the context has them and start the writers. The OpenGL RC must be set.
+     *
+     * @param writerCount writer threads, at least 1
+     * @param queueDepth frames read back but not written before submit() waits
+     */
+    void init(int width, int height, size_t writerCount, size_t queueDepth);
+
+    bool hasAsyncReadback();
+
+    /**
+     * @brief Start reading the current frame of the bound framebuffer, to be written to path
+     *
+     */
+    void submit(const std::string &path);
+
+    /**
+     * @brief Read back and write every submitted frame, then stop the writers and delete the pixel buffers
+     *
+     * @return frames written
+     */
+    size_t finish();
+
+    size_t getFailureCount();
+
+    /**
+     * @brief Time submit() spent waiting for a full queue (s)
+     *
+     */
+    double getStallSeconds();
+};
+
+#endif
@@ -0,0 +1,209 @@
+#include "frameProfiler.hpp"
+#include "glResources.hpp"
+#include <algorithm>
+#include <iostream>
+
+using std::cerr;
+using std::endl;
+
+//===============================================================================================================
+// FrameProfiler Class
+//...............................................................................................................
+// Constructor
+//...............................................................................................................
+FrameProfiler::FrameProfiler() {
+    this->gpuTimers = false;
+    for (size_t f = 0; f < LATENCY; f++) {
+        for (int p = 0; p < PHASE_COUNT; p++)
+            this->queries[f][p] = 0;
+        this->frames[f] = Frame();
+        this->frames[f].pending = false;
+    }
+    this->frameNumber = 0;
+    this->phase = -1;
+    this->cpuHistory.assign(HISTORY, 0);
+    this->gpuHistory.assign(HISTORY, 0);
+    this->cpuCount = this->gpuCount = 0;
+    this->last = Frame();
+}
+
+//...............................................................................................................
+// Public Methods
+//...............................................................................................................
+void FrameProfiler::init(std::string csvPath) {
+#ifdef RENDER_SHADERS_SUPPORTED
+    if (render::hasVersion(3, 3)) {
+        glGenQueries(LATENCY * PHASE_COUNT, &this->queries[0][0]);
+        this->gpuTimers = true;
+    }
+#endif
+    if (csvPath.empty())
+        return;
+    this->csv.open(csvPath.c_str());
+    if (!this->csv) {
+        cerr << "Unable to write the frame times to " << csvPath << endl;
+        return;
+    }
+    this->csv << "frame";
+    for (int p = 0; p < PHASE_COUNT; p++)
+        this->csv << ",cpu_" << PHASE_NAMES[p] << "_ms";
+    this->csv << ",cpu_total_ms";
+    for (int p = 0; p < PHASE_COUNT; p++)
+        this->csv << ",gpu_" << PHASE_NAMES[p] << "_ms";
+    this->csv << ",gpu_total_ms" << endl;
+}
+
+void FrameProfiler::release() {
+#ifdef RENDER_SHADERS_SUPPORTED
+    // Frames still in flight go to the log before their queries are deleted
+    for (size_t f = 0; f < LATENCY; f++) {
+        size_t slot = (this->frameNumber + f) % LATENCY;
+        if (this->frames[slot].pending)
+            this->collect(this->frames[slot], this->queries[slot]);
+    }
+    if (this->gpuTimers)
+        glDeleteQueries(LATENCY * PHASE_COUNT, &this->queries[0][0]);
+#endif
+    this->gpuTimers = false;
+    if (this->csv.is_open())
+        this->csv.close();
+}
+
+bool FrameProfiler::hasGpuTimers() {
+    return this->gpuTimers;
+}
+
+void FrameProfiler::beginFrame() {
+    // Read back finished frames oldest first. The oldest one holds the slot about to be reused and is read
+    // even if it has to wait, which only happens when the GPU is LATENCY frames behind.
+    for (size_t f = 0; f < LATENCY; f++) {
+        size_t slot = (this->frameNumber + f) % LATENCY;
+        if (!this->frames[slot].pending)
+            continue;
+#ifdef RENDER_SHADERS_SUPPORTED
+        GLint available = 1;
+        for (int p = 0; p < PHASE_COUNT && available && f > 0; p++)
+            glGetQueryObjectiv(this->queries[slot][p], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            break;
+#endif
+        this->collect(this->frames[slot], this->queries[slot]);
+    }
+    Frame &frame = this->frames[this->frameNumber % LATENCY];
+    frame = Frame();
+    frame.number = this->frameNumber;
+    frame.pending = false;
+}
+
+void FrameProfiler::beginPhase(FramePhase phase) {
+    if (this->phase >= 0)
+        this->endPhase();
+    this->phase = phase;
+    this->frames[this->frameNumber % LATENCY].ran[phase] = true;
+#ifdef RENDER_SHADERS_SUPPORTED
+    if (this->gpuTimers)
+        glBeginQuery(GL_TIME_ELAPSED, this->queries[this->frameNumber % LATENCY][phase]);
+#endif
+    this->phaseStart = std::chrono::steady_clock::now();
+}
+
+void FrameProfiler::endPhase() {
+    if (this->phase < 0)
+        return;
+    Frame &frame = this->frames[this->frameNumber % LATENCY];
+    frame.cpu[this->phase] += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - this->phaseStart).count();
+#ifdef RENDER_SHADERS_SUPPORTED
+    if (this->gpuTimers)
+        glEndQuery(GL_TIME_ELAPSED);
+#endif
+    this->phase = -1;
+}
+
+void FrameProfiler::endFrame() {
+    this->endPhase();
+    Frame &frame = this->frames[this->frameNumber % LATENCY];
+    double total = 0;
+    for (int p = 0; p < PHASE_COUNT; p++)
+        total += frame.cpu[p];
+    this->cpuHistory[this->cpuCount % HISTORY] = (float)total;
+    this->cpuCount++;
+
+    // A phase that did not run this frame still needs its query to have a result
+#ifdef RENDER_SHADERS_SUPPORTED
+    if (this->gpuTimers) {
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            if (!frame.ran[p]) {
+                glBeginQuery(GL_TIME_ELAPSED, this->queries[this->frameNumber % LATENCY][p]);
+                glEndQuery(GL_TIME_ELAPSED);
+            }
+        }
+    }
+#endif
+    // The first frame pays for the driver warm-up, and llvmpipe reports garbage for a query issued before
+    // anything was drawn, so its GPU time is left out
+    frame.pending = this->gpuTimers && this->frameNumber > 0;
+    if (!frame.pending)
+        this->record(frame);
+    this->frameNumber++;
+}
+
+float FrameProfiler::getPercentile(float percentile, bool gpu) {
+    std::vector<float> times = this->getHistory(gpu);
+    if (times.empty())
+        return 0;
+    size_t rank = std::min(times.size() - 1, (size_t)(percentile / 100 * times.size()));
+    std::nth_element(times.begin(), times.begin() + rank, times.end());
+    return times[rank];
+}
+
+std::vector<float> FrameProfiler::getHistory(bool gpu) {
+    const std::vector<float> &ring = gpu ? this->gpuHistory : this->cpuHistory;
+    size_t count = gpu ? this->gpuCount : this->cpuCount;
+    std::vector<float> times;
+    size_t kept = std::min(count, HISTORY);
+    times.reserve(kept);
+    for (size_t i = count - kept; i < count; i++)
+        times.push_back(ring[i % HISTORY]);
+    return times;
+}
+
+double FrameProfiler::getPhaseTime(FramePhase phase, bool gpu) {
+    return gpu ? this->last.gpu[phase] : this->last.cpu[phase];
+}
+
+//...............................................................................................................
+// Private Methods
+//...............................................................................................................
+void FrameProfiler::collect(Frame &frame, unsigned int *frameQueries) {
+#ifdef RENDER_SHADERS_SUPPORTED
+    double total = 0;
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(frameQueries[p], GL_QUERY_RESULT, &elapsed);
+        frame.gpu[p] = elapsed / 1.0e6;
+        total += frame.gpu[p];
+    }
+    this->gpuHistory[this->gpuCount % HISTORY] = (float)total;
+    this->gpuCount++;
+#endif
+    frame.pending = false;
+    this->record(frame);
+}
+
+void FrameProfiler::record(const Frame &frame) {
+    this->last = frame;
+    if (!this->csv.is_open())
+        return;
+    double cpuTotal = 0, gpuTotal = 0;
+    this->csv << frame.number;
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        this->csv << "," << frame.cpu[p];
+        cpuTotal += frame.cpu[p];
+    }
+    this->csv << "," << cpuTotal;
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        this->csv << "," << frame.gpu[p];
+        gpuTotal += frame.gpu[p];
+    }
+    this->csv << "," << gpuTotal << "\n";
+}
@@ -0,0 +1,107 @@
+#ifndef FrameProfiler_h
+#define FrameProfiler_h
+
+#include <stddef.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+
+/**
+ * @brief Parts of a frame timed separately
+ *
+ */
+enum FramePhase {
+    PHASE_CULL,         // frustum setup, culling and the visible list
+    PHASE_DRAW,         // draw submissions of the bodies, points and asteroids
+    PHASE_HUD,          // text and overlay
+    PHASE_SWAP,         // buffer swap
+    PHASE_COUNT
+};
+
+const char *const PHASE_NAMES[PHASE_COUNT] = {"cull", "draw", "hud", "swap"};
+
+/**
+ * @brief CPU and GPU time of each frame phase, with rolling percentiles over the last frames and an optional CSV log.
+ * CPU time is wall time around the phase on the render thread. GPU time comes from GL_TIME_ELAPSED queries,
+ * read back a few frames later so the CPU never waits on them; without timer queries it stays at 0.
+ *
+ */
+class FrameProfiler {
+public:
+    static const size_t HISTORY = 240;      // frames kept for the percentiles and the graph
+
+private:
+    static const size_t LATENCY = 4;        // frames of queries in flight
+
+    struct Frame {
+        unsigned long number;
+        double cpu[PHASE_COUNT];            // ms
+        double gpu[PHASE_COUNT];
+        bool ran[PHASE_COUNT];
+        bool pending;                       // GPU queries not read yet
+    };
+
+    bool gpuTimers;
+    unsigned int queries[LATENCY][PHASE_COUNT];
+    Frame frames[LATENCY];
+    unsigned long frameNumber;
+    int phase;                              // running phase, -1 between phases
+    std::chrono::steady_clock::time_point phaseStart;
+
+    std::vector<float> cpuHistory;          // total ms per frame, ring
+    std::vector<float> gpuHistory;
+    size_t cpuCount;
+    size_t gpuCount;
+    Frame last;                             // latest frame with its GPU times
+
+    std::ofstream csv;
+
+    void collect(Frame &frame, unsigned int *frameQueries);
+    void record(const Frame &frame);
+
+public:
+    FrameProfiler();
+
+    /**
+     * @brief Create the timer queries if the context has them. The OpenGL RC must be set.
+     *
+     * @param csvPath write a line per frame there, empty for none
+     */
+    void init(std::string csvPath);
+    void release();
+
+    bool hasGpuTimers();
+
+    void beginFrame();
+
+    /**
+     * @brief Start timing a phase, ending the running one. Each phase runs at most once per frame.
+     *
+     */
+    void beginPhase(FramePhase phase);
+    void endPhase();
+    void endFrame();
+
+    /**
+     * @brief Percentile of the frame time over the kept history (ms), 0 without frames
+     *
+     * @param percentile from 0 to 100
+     * @param gpu GPU instead of CPU time
+     */
+    float getPercentile(float percentile, bool gpu);
+
+    /**
+     * @brief Frame times of the kept history, oldest first
+     *
+     */
+    std::vector<float> getHistory(bool gpu);
+
+    /**
+     * @brief Phase times of the latest frame whose GPU time is known (ms)
+     *
+     */
+    double getPhaseTime(FramePhase phase, bool gpu);
+};
+
+#endif
@@ -0,0 +1,106 @@
+#include "frustum.hpp"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+
+//===============================================================================================================
+// Constants Definition
+//===============================================================================================================
+static const size_t BLOCK = 64;     // spheres per pass of the plane tests
+
+//===============================================================================================================
+// Frustum Class
+//...............................................................................................................
+// Constructor
+//...............................................................................................................
+Frustum::Frustum() {
+    // Everything is inside until set
+    for (int p = 0; p < 6; p++) {
+        this->planes[p][0] = this->planes[p][1] = this->planes[p][2] = 0;
+        this->planes[p][3] = 1;
+    }
+}
+
+//...............................................................................................................
+// Public Methods
+//...............................................................................................................
+void Frustum::set(glm::vec3 camera, glm::vec3 target, glm::vec3 up, float fov, float aspect, float near, float far) {
+    this->camera = camera;
+    glm::vec3 forward = glm::normalize(target - camera);
+    glm::vec3 right = glm::normalize(glm::cross(forward, up));
+    glm::vec3 trueUp = glm::cross(right, forward);
+    float tanV = tanf(fov * (float)M_PI / 360);
+    float tanH = tanV * aspect;
+
+    // Side planes go through the camera, each normal leans from the edge towards the view direction
+    glm::vec3 normals[6] = {
+        glm::normalize(right + forward * tanH),     // left
+        glm::normalize(-right + forward * tanH),    // right
+        glm::normalize(trueUp + forward * tanV),    // bottom
+        glm::normalize(-trueUp + forward * tanV),   // top
+        forward,                                    // near
+        -forward                                    // far
+    };
+    float offsets[6] = {0, 0, 0, 0, -near, far};
+    for (int p = 0; p < 6; p++) {
+        this->planes[p][0] = normals[p].x;
+        this->planes[p][1] = normals[p].y;
+        this->planes[p][2] = normals[p].z;
+        this->planes[p][3] = offsets[p];
+    }
+}
+
+bool Frustum::contains(glm::vec3 center, float radius) const {
+    glm::vec3 p = center - this->camera;
+    for (int i = 0; i < 6; i++) {
+        if (this->planes[i][0] * p.x + this->planes[i][1] * p.y + this->planes[i][2] * p.z + this->planes[i][3] < -radius)
+            return false;
+    }
+    return true;
+}
+
+size_t Frustum::cull(const float *x, const float *y, const float *z, const float *radius, size_t count, int *visible) const {
+    float cx = this->camera.x, cy = this->camera.y, cz = this->camera.z;
+    size_t visibleCount = 0;
+    for (size_t begin = 0; begin < count; begin += BLOCK) {
+        size_t n = std::min(BLOCK, count - begin);
+        const float *bx = x + begin, *by = y + begin, *bz = z + begin, *br = radius + begin;
+
+        // Camera relative centers. The last partial block is padded so every pass below has the full block
+        // width, which lets the compiler vectorize it at -O2
+        float px[BLOCK], py[BLOCK], pz[BLOCK], r[BLOCK], inside[BLOCK];
+        if (n == BLOCK) {
+            for (size_t i = 0; i < BLOCK; i++) {
+                px[i] = bx[i] - cx;
+                py[i] = by[i] - cy;
+                pz[i] = bz[i] - cz;
+                r[i] = br[i];
+            }
+        } else {
+            for (size_t i = 0; i < BLOCK; i++) {
+                px[i] = (i < n) ? bx[i] - cx : 0;
+                py[i] = (i < n) ? by[i] - cy : 0;
+                pz[i] = (i < n) ? bz[i] - cz : 0;
+                r[i] = (i < n) ? br[i] : 0;
+            }
+        }
+
+        // Signed distance to the nearest plane, the sphere is out if it is further than its radius outside.
+        for (size_t i = 0; i < BLOCK; i++)
+            inside[i] = FLT_MAX;
+        for (int p = 0; p < 6; p++) {
+            float a = this->planes[p][0], b = this->planes[p][1], c = this->planes[p][2], d = this->planes[p][3];
+            for (size_t i = 0; i < BLOCK; i++)
+                inside[i] = std::min(inside[i], a * px[i] + b * py[i] + c * pz[i] + d);
+        }
+        for (size_t i = 0; i < BLOCK; i++)
+            inside[i] += r[i];
+
+        // Compact without branching, every index is written and kept only if inside
+        for (size_t i = 0; i < n; i++) {
+            visible[visibleCount] = (int)(begin + i);
+            visibleCount += (inside[i] >= 0);
+        }
+    }
+    return visibleCount;
+}
@@ -0,0 +1,45 @@
+#ifndef Frustum_h
+#define Frustum_h
+
+#include <stddef.h>
+#include <glm/glm.hpp>
+
+/**
+ * @brief View frustum as six planes, for culling bodies by their bounding spheres.
+ * The planes are kept relative to the camera so solar system sized coordinates keep their precision,
+ * and culling walks the body arrays in fixed width blocks with no branches in the plane tests.
+ *
+ */
+class Frustum {
+private:
+    glm::vec3 camera;
+    float planes[6][4];     // inward normal and offset, a point p is inside when n.(p - camera) + d >= 0
+
+public:
+    Frustum();
+
+    /**
+     * @brief Set the frustum of a perspective camera
+     *
+     * @param fov vertical field of view (degrees)
+     * @param aspect width over height
+     * @param near, far clip range from the camera along the view direction
+     */
+    void set(glm::vec3 camera, glm::vec3 target, glm::vec3 up, float fov, float aspect, float near, float far);
+
+    /**
+     * @brief Check a single sphere
+     *
+     */
+    bool contains(glm::vec3 center, float radius) const;
+
+    /**
+     * @brief Cull spheres given as one array per coordinate
+     *
+     * @param visible receives the indexes of the spheres at least partly inside, in order, room for count
+     * @return the number of visible spheres
+     */
+    size_t cull(const float *x, const float *y, const float *z, const float *radius, size_t count, int *visible) const;
+};
+
+#endif
@@ -0,0 +1,192 @@
+#include "glResources.hpp"
+#include "../Bmp.h"
+
+#ifdef __APPLE__
+#include <OpenGL/glu.h>
+#else
+#include <GL/glu.h>
+#endif
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+using std::endl;
+using std::cerr;
+
+//===============================================================================================================
+// Constants Definition
+//===============================================================================================================
+static const int MAX_LAYER_SIZE = 4096;
+
+//===============================================================================================================
+// Helper Function Definition
+//===============================================================================================================
+#ifdef RENDER_SHADERS_SUPPORTED
+static GLuint compileShader(GLenum type, const char *source, const char *name);
+#endif
+
+namespace render {
+
+//===============================================================================================================
+// Context
+//...............................................................................................................
+bool hasVersion(int major, int minor) {
+    const char *version = (const char *)glGetString(GL_VERSION);
+    if (version == NULL)
+        return false;
+    int contextMajor = atoi(version);
+    int contextMinor = (strchr(version, '.') != NULL) ? atoi(strchr(version, '.') + 1) : 0;
+    return contextMajor > major || (contextMajor == major && contextMinor >= minor);
+}
+
+//===============================================================================================================
+// Programs
+//...............................................................................................................
+unsigned int buildProgram(const char *vertexSource, const char *fragmentSource,
+                          const char *const *attributes, size_t attributeCount, const char *name) {
+#ifdef RENDER_SHADERS_SUPPORTED
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource, name);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource, name);
+    if (vertexShader == 0 || fragmentShader == 0) {
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        return 0;
+    }
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    for (size_t i = 0; i < attributeCount; i++)
+        glBindAttribLocation(program, (GLuint)i, attributes[i]);
+    glLinkProgram(program);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    GLint linked;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        char log[2048];
+        glGetProgramInfoLog(program, sizeof(log), NULL, log);
+        cerr << "Unable to link the " << name << " shader: " << log << endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+#else
+    return 0;
+#endif
+}
+
+//===============================================================================================================
+// Textures
+//...............................................................................................................
+unsigned int loadTextureArray(const std::vector<std::string> &imagePaths) {
+#ifdef RENDER_SHADERS_SUPPORTED
+    std::vector<Image::Bmp> images(imagePaths.size());
+    std::vector<bool> loaded(imagePaths.size(), false);
+    GLint maxSize;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    int width = 1, height = 1;
+    for (size_t layer = 0; layer < imagePaths.size(); layer++) {
+        if (!images[layer].read(imagePaths[layer].c_str()))
+            continue;
+        int bpp = images[layer].getBitCount();
+        loaded[layer] = (bpp == 8 || bpp == 24 || bpp == 32);
+        if (!loaded[layer])
+            continue;
+        width = std::max(width, std::min(images[layer].getWidth(), std::min<int>(maxSize, MAX_LAYER_SIZE)));
+        height = std::max(height, std::min(images[layer].getHeight(), std::min<int>(maxSize, MAX_LAYER_SIZE)));
+    }
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGB8, width, height, (GLsizei)imagePaths.size(), 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+
+    std::vector<unsigned char> scaled(4 * width * height);
+    for (size_t layer = 0; layer < imagePaths.size(); layer++) {
+        const Image::Bmp &image = images[layer];
+        if (!loaded[layer]) {
+            // Untextured bodies keep their lit material color, as with texture 0 on the fixed-function path
+            std::fill(scaled.begin(), scaled.end(), 255);
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, GL_RGB, GL_UNSIGNED_BYTE, scaled.data());
+            continue;
+        }
+        GLenum format = (image.getBitCount() == 8) ? GL_LUMINANCE : ((image.getBitCount() == 24) ? GL_RGB : GL_RGBA);
+        const void *pixels = image.getDataRGB();
+        if (image.getWidth() != width || image.getHeight() != height) {
+            gluScaleImage(format, image.getWidth(), image.getHeight(), GL_UNSIGNED_BYTE, pixels,
+                          width, height, GL_UNSIGNED_BYTE, scaled.data());
+            pixels = scaled.data();
+        }
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, format, GL_UNSIGNED_BYTE, pixels);
+    }
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    return texture;
+#else
+    return 0;
+#endif
+}
+
+//===============================================================================================================
+// Vertex Arrays
+//...............................................................................................................
+unsigned int createInstancedSphere(const Sphere &sphere, unsigned int instanceBuffer) {
+#ifdef RENDER_SHADERS_SUPPORTED
+    // Mesh attributes from the sphere buffers, body attributes advance once per instance
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, sphere.getVertexBuffer());
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphere.getIndexBuffer());
+    GLsizei stride = sphere.getInterleavedStride();
+    glEnableVertexAttribArray(ATTRIBUTE_VERTEX);
+    glEnableVertexAttribArray(ATTRIBUTE_NORMAL);
+    glEnableVertexAttribArray(ATTRIBUTE_TEXCOORD);
+    glVertexAttribPointer(ATTRIBUTE_VERTEX, 3, GL_FLOAT, GL_FALSE, stride, (void *)0);
+    glVertexAttribPointer(ATTRIBUTE_NORMAL, 3, GL_FLOAT, GL_FALSE, stride, (void *)(3 * sizeof(float)));
+    glVertexAttribPointer(ATTRIBUTE_TEXCOORD, 2, GL_FLOAT, GL_FALSE, stride, (void *)(6 * sizeof(float)));
+
+    GLsizei instanceStride = INSTANCE_FLOATS * sizeof(float);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glEnableVertexAttribArray(ATTRIBUTE_BODY);
+    glEnableVertexAttribArray(ATTRIBUTE_STYLE);
+    glVertexAttribPointer(ATTRIBUTE_BODY, 4, GL_FLOAT, GL_FALSE, instanceStride, (void *)0);
+    glVertexAttribPointer(ATTRIBUTE_STYLE, 2, GL_FLOAT, GL_FALSE, instanceStride, (void *)(4 * sizeof(float)));
+    glVertexAttribDivisor(ATTRIBUTE_BODY, 1);
+    glVertexAttribDivisor(ATTRIBUTE_STYLE, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return vao;
+#else
+    return 0;
+#endif
+}
+
+} // namespace render
+
+//===============================================================================================================
+// Helper Functions
+//===============================================================================================================
+#ifdef RENDER_SHADERS_SUPPORTED
+static GLuint compileShader(GLenum type, const char *source, const char *name) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    GLint compiled;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (!compiled) {
+        char log[2048];
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        cerr << "Unable to compile the " << name << " shader: " << log << endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+#endif
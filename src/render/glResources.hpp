@@ -0,0 +1,78 @@
+#ifndef GlResources_h
+#define GlResources_h
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include "../Sphere.h"
+
+// Buffer, shader and texture array entry points straight from the GL library, no loader
+#define GL_GLEXT_PROTOTYPES
+#ifdef __APPLE__
+#include <OpenGL/gl.h>
+#else
+#include <GL/gl.h>
+#endif
+
+// The shader paths need GL 3.3 headers, other platforms only have the fixed-function path
+#if defined(GL_VERSION_3_3) && !defined(__APPLE__)
+#define RENDER_SHADERS_SUPPORTED
+#endif
+
+/**
+ * GL objects shared by the shader based renderers. The OpenGL RC must be set for all of them.
+ */
+namespace render {
+
+/**
+ * @brief Vertex attributes of the instanced sphere, the sphere mesh then one instance per body
+ *
+ */
+enum InstanceAttribute {
+    ATTRIBUTE_VERTEX,
+    ATTRIBUTE_NORMAL,
+    ATTRIBUTE_TEXCOORD,
+    ATTRIBUTE_BODY,         // x, y, z, radius
+    ATTRIBUTE_STYLE,        // material, texture layer
+    ATTRIBUTE_COUNT
+};
+
+const char *const ATTRIBUTE_NAMES[ATTRIBUTE_COUNT] = {"vertex", "normal", "texCoord", "body", "style"};
+const size_t INSTANCE_FLOATS = 6;
+
+/**
+ * @brief Check the version of the current context, the headers may be newer than the driver
+ *
+ */
+bool hasVersion(int major, int minor);
+
+/**
+ * @brief Compile and link a program, printing the log on failure
+ *
+ * @param attributes vertex attribute names, bound to their index in the array
+ * @param name program name for the error messages
+ * @return the program, 0 on failure
+ */
+unsigned int buildProgram(const char *vertexSource, const char *fragmentSource,
+                          const char *const *attributes, size_t attributeCount, const char *name);
+
+/**
+ * @brief Load BMP images as the layers of a mipmapped GL_TEXTURE_2D_ARRAY, in order.
+ * Every layer has the size of the largest image, the others are scaled up to it, and an image
+ * that cannot be read leaves its layer white.
+ *
+ * @return the texture, 0 without shader support
+ */
+unsigned int loadTextureArray(const std::vector<std::string> &imagePaths);
+
+/**
+ * @brief Vertex array drawing the sphere buffers once per instance of an instance buffer
+ * (INSTANCE_FLOATS per instance in the InstanceAttribute order)
+ *
+ * @return the vertex array, 0 without shader support
+ */
+unsigned int createInstancedSphere(const Sphere &sphere, unsigned int instanceBuffer);
+
+} // namespace render
+
+#endif
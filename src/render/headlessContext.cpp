@@ -0,0 +1,134 @@
+#include "headlessContext.hpp"
+#include "glResources.hpp"
+#ifdef RENDER_SHADERS_SUPPORTED
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+#include <iostream>
+#include <string.h>
+
+//===============================================================================================================
+// HeadlessContext Class
+//...............................................................................................................
+// Constructor
+//...............................................................................................................
+HeadlessContext::HeadlessContext() {
+    this->display = NULL;
+    this->context = NULL;
+    this->framebuffer = 0;
+    this->renderbuffers[0] = this->renderbuffers[1] = 0;
+    this->width = this->height = 0;
+}
+
+HeadlessContext::~HeadlessContext() {
+    this->release();
+}
+
+//...............................................................................................................
+// Public Methods
+//...............................................................................................................
+bool HeadlessContext::init(int width, int height) {
+#ifdef RENDER_SHADERS_SUPPORTED
+    // The surfaceless platform needs no native display at all, EGL_PLATFORM=surfaceless does the same
+    // for an EGL without the platform extension
+    EGLDisplay display = EGL_NO_DISPLAY;
+    const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (clientExtensions != NULL && strstr(clientExtensions, "EGL_MESA_platform_surfaceless") != NULL && getPlatformDisplay != NULL)
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    EGLint major, minor;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+        std::cerr << "EGL display unavailable (error 0x" << std::hex << eglGetError() << std::dec << ")" << std::endl;
+        return false;
+    }
+    this->display = display;
+
+    // No surface is ever created, so any config (or none) will do
+    const char *extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (extensions == NULL || strstr(extensions, "EGL_KHR_surfaceless_context") == NULL) {
+        std::cerr << "EGL display without surfaceless contexts" << std::endl;
+        this->release();
+        return false;
+    }
+    EGLint configAttributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+    EGLConfig config = NULL;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0)
+        config = NULL;          // EGL_NO_CONFIG_KHR
+    eglBindAPI(EGL_OPENGL_API);
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, NULL);
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        std::cerr << "EGL context unavailable (error 0x" << std::hex << eglGetError() << std::dec << ")" << std::endl;
+        if (context != EGL_NO_CONTEXT)
+            eglDestroyContext(display, context);
+        this->release();
+        return false;
+    }
+    this->context = context;
+    if (!render::hasVersion(3, 0)) {
+        std::cerr << "Headless context is OpenGL " << glGetString(GL_VERSION) << ", framebuffer objects need 3.0" << std::endl;
+        this->release();
+        return false;
+    }
+
+    // The framebuffer stays bound, everything drawn from here on lands in it
+    glGenRenderbuffers(2, this->renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, this->renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, this->renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glGenFramebuffers(1, &this->framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, this->renderbuffers[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, this->renderbuffers[1]);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Headless framebuffer of " << width << " x " << height << " incomplete" << std::endl;
+        this->release();
+        return false;
+    }
+    this->width = width;
+    this->height = height;
+    glViewport(0, 0, width, height);
+    std::cout << "Headless OpenGL " << glGetString(GL_VERSION) << " on " << glGetString(GL_RENDERER) << std::endl;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void HeadlessContext::release() {
+#ifdef RENDER_SHADERS_SUPPORTED
+    if (this->context != NULL) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (this->framebuffer != 0)
+            glDeleteFramebuffers(1, &this->framebuffer);
+        if (this->renderbuffers[0] != 0)
+            glDeleteRenderbuffers(2, this->renderbuffers);
+        eglMakeCurrent(this->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(this->display, this->context);
+    }
+    if (this->display != NULL)
+        eglTerminate(this->display);
+#endif
+    this->display = NULL;
+    this->context = NULL;
+    this->framebuffer = 0;
+    this->renderbuffers[0] = this->renderbuffers[1] = 0;
+    this->width = this->height = 0;
+}
+
+bool HeadlessContext::isReady() const {
+    return this->framebuffer != 0;
+}
+
+int HeadlessContext::getWidth() const {
+    return this->width;
+}
+
+int HeadlessContext::getHeight() const {
+    return this->height;
+}
@@ -0,0 +1,43 @@
+#ifndef HeadlessContext_h
+#define HeadlessContext_h
+
+#include <stddef.h>
+
+/**
+ * @brief OpenGL context without a window or display server, drawing into a framebuffer object.
+ * The context comes from EGL on the surfaceless Mesa platform, so it runs on llvmpipe with no GPU and no X
+ * server. It is a compatibility profile context, the fixed-function and shader paths both draw into it.
+ *
+ */
+class HeadlessContext {
+private:
+    void *display;                      // EGLDisplay
+    void *context;                      // EGLContext
+    unsigned int framebuffer;
+    unsigned int renderbuffers[2];      // color, depth and stencil
+    int width;
+    int height;
+
+public:
+    HeadlessContext();
+    ~HeadlessContext();
+
+    /**
+     * @brief Create the context, make it current and bind a width x height framebuffer for drawing
+     *
+     * @return false if EGL, the surfaceless platform or framebuffer objects are unavailable
+     */
+    bool init(int width, int height);
+
+    /**
+     * @brief Delete the framebuffer and the context
+     *
+     */
+    void release();
+
+    bool isReady() const;
+    int getWidth() const;
+    int getHeight() const;
+};
+
+#endif
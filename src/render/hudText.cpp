@@ -0,0 +1,230 @@
+#include "hudText.hpp"
+#include "glResources.hpp"
+#ifdef __APPLE__
+#include <GLUT/glut.h>
+#else
+#include <GL/glut.h>
+#endif
+#include <algorithm>
+#include <string.h>
+
+//===============================================================================================================
+// Constants Definition
+//===============================================================================================================
+static const int FIRST_GLYPH = 32;          // space
+static const int GLYPH_COUNT = 96;          // to DEL
+static const int ATLAS_COLUMNS = 16;
+static const size_t VERTEX_FLOATS = 8;
+
+//===============================================================================================================
+// HudText Class
+//...............................................................................................................
+// Constructor
+//...............................................................................................................
+HudText::HudText() {
+    this->font = NULL;
+    this->cellWidth = this->cellHeight = 0;
+    this->descent = 0;
+    memset(this->advances, 0, sizeof(this->advances));
+    this->atlas = 0;
+    this->vbo = 0;
+    this->lineCount = 0;
+    this->dirty = false;
+    this->tessellations = 0;
+}
+
+//...............................................................................................................
+// Public Methods
+//...............................................................................................................
+bool HudText::init(void *font, int cellWidth, int cellHeight) {
+    this->font = font;
+    this->cellWidth = cellWidth;
+    this->cellHeight = cellHeight;
+    this->descent = cellHeight / 4;
+    for (int c = FIRST_GLYPH; c < FIRST_GLYPH + GLYPH_COUNT - 1; c++)
+        this->advances[c] = (unsigned char)glutBitmapWidth(font, c);
+#ifdef RENDER_SHADERS_SUPPORTED
+    if (!render::hasVersion(3, 0))
+        return false;
+    int width = ATLAS_COLUMNS * cellWidth;
+    int height = (GLYPH_COUNT / ATLAS_COLUMNS) * cellHeight;
+    glGenTextures(1, &this->atlas);
+    glBindTexture(GL_TEXTURE_2D, this->atlas);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Rasterize every glyph once into its cell, white and opaque on a transparent background
+    GLint previousFramebuffer;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    GLuint framebuffer;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->atlas, 0);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (complete) {
+        glPushAttrib(GL_ALL_ATTRIB_BITS);
+        glViewport(0, 0, width, height);
+        glDisable(GL_LIGHTING);
+        glDisable(GL_TEXTURE_2D);
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+        glClearColor(0, 0, 0, 0);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glMatrixMode(GL_PROJECTION);
+        glPushMatrix();
+        glLoadIdentity();
+        glOrtho(0, width, 0, height, -1, 1);
+        glMatrixMode(GL_MODELVIEW);
+        glPushMatrix();
+        glLoadIdentity();
+        glColor4f(1, 1, 1, 1);
+        for (int g = 0; g < GLYPH_COUNT - 1; g++) {
+            glRasterPos2i((g % ATLAS_COLUMNS) * cellWidth, (g / ATLAS_COLUMNS) * cellHeight + this->descent);
+            glutBitmapCharacter(font, FIRST_GLYPH + g);
+        }
+        glPopMatrix();
+        glMatrixMode(GL_PROJECTION);
+        glPopMatrix();
+        glMatrixMode(GL_MODELVIEW);
+        glPopAttrib();
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+    glDeleteFramebuffers(1, &framebuffer);
+    if (!complete) {
+        glDeleteTextures(1, &this->atlas);
+        this->atlas = 0;
+        return false;
+    }
+    glGenBuffers(1, &this->vbo);
+    this->dirty = true;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void HudText::release() {
+#ifdef RENDER_SHADERS_SUPPORTED
+    if (this->vbo != 0)
+        glDeleteBuffers(1, &this->vbo);
+    if (this->atlas != 0)
+        glDeleteTextures(1, &this->atlas);
+    this->vbo = this->atlas = 0;
+#endif
+}
+
+bool HudText::isReady() {
+    return this->atlas != 0;
+}
+
+void HudText::setLine(size_t index, const std::string &text, int x, int y, const float color[4]) {
+    if (index >= this->lines.size()) {
+        this->lines.resize(index + 1);
+        this->lines[index].x = this->lines[index].y = -1;
+        memset(this->lines[index].color, 0, sizeof(this->lines[index].color));
+    }
+    Line &line = this->lines[index];
+    if (line.text == text && line.x == x && line.y == y && memcmp(line.color, color, sizeof(line.color)) == 0)
+        return;
+    line.text = text;
+    line.x = x;
+    line.y = y;
+    memcpy(line.color, color, sizeof(line.color));
+    this->tessellate(line);
+    this->dirty = true;
+}
+
+void HudText::setLineCount(size_t count) {
+    count = std::min(count, this->lines.size());
+    if (count != this->lineCount)
+        this->dirty = true;
+    this->lineCount = count;
+}
+
+void HudText::draw() {
+    if (this->atlas == 0) {
+        // Per character fallback, as drawString does it
+        glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT);
+        glDisable(GL_LIGHTING);
+        glDisable(GL_TEXTURE_2D);
+        for (size_t l = 0; l < this->lineCount; l++) {
+            glColor4fv(this->lines[l].color);
+            glRasterPos2i(this->lines[l].x, this->lines[l].y);
+            for (const char *c = this->lines[l].text.c_str(); *c; c++)
+                glutBitmapCharacter(this->font, *c);
+        }
+        glPopAttrib();
+        return;
+    }
+#ifdef RENDER_SHADERS_SUPPORTED
+    glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
+    if (this->dirty) {
+        this->vertices.clear();
+        for (size_t l = 0; l < this->lineCount; l++)
+            this->vertices.insert(this->vertices.end(), this->lines[l].vertices.begin(), this->lines[l].vertices.end());
+        glBufferData(GL_ARRAY_BUFFER, this->vertices.size() * sizeof(float), this->vertices.data(), GL_DYNAMIC_DRAW);
+        this->dirty = false;
+    }
+
+    glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_TEXTURE_BIT);
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glEnable(GL_TEXTURE_2D);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    glBindTexture(GL_TEXTURE_2D, this->atlas);
+
+    GLsizei stride = VERTEX_FLOATS * sizeof(float);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, stride, (void *)0);
+    glTexCoordPointer(2, GL_FLOAT, stride, (void *)(2 * sizeof(float)));
+    glColorPointer(4, GL_FLOAT, stride, (void *)(4 * sizeof(float)));
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(this->vertices.size() / VERTEX_FLOATS));
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPopClientAttrib();
+    glPopAttrib();
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+#endif
+}
+
+unsigned int HudText::getTessellationCount() {
+    return this->tessellations;
+}
+
+//...............................................................................................................
+// Private Methods
+//...............................................................................................................
+void HudText::tessellate(Line &line) {
+    line.vertices.clear();
+    float atlasWidth = (float)(ATLAS_COLUMNS * this->cellWidth);
+    float atlasHeight = (float)((GLYPH_COUNT / ATLAS_COLUMNS) * this->cellHeight);
+    int penX = line.x;
+    for (unsigned char c : line.text) {
+        if (c < FIRST_GLYPH || c >= FIRST_GLYPH + GLYPH_COUNT - 1)
+            continue;
+        int g = c - FIRST_GLYPH;
+        float x0 = (float)penX, y0 = (float)(line.y - this->descent);
+        float x1 = x0 + this->cellWidth, y1 = y0 + this->cellHeight;
+        float s0 = (g % ATLAS_COLUMNS) * this->cellWidth / atlasWidth;
+        float t0 = (g / ATLAS_COLUMNS) * this->cellHeight / atlasHeight;
+        float s1 = s0 + this->cellWidth / atlasWidth, t1 = t0 + this->cellHeight / atlasHeight;
+        const float corners[6][4] = {{x0, y0, s0, t0}, {x1, y0, s1, t0}, {x1, y1, s1, t1},
+                                     {x0, y0, s0, t0}, {x1, y1, s1, t1}, {x0, y1, s0, t1}};
+        for (const float *corner : corners) {
+            line.vertices.insert(line.vertices.end(), corner, corner + 4);
+            line.vertices.insert(line.vertices.end(), line.color, line.color + 4);
+        }
+        penX += this->advances[c];
+    }
+    this->tessellations++;
+}
@@ -0,0 +1,79 @@
+#ifndef HudText_h
+#define HudText_h
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Screen text drawn from a glyph atlas in one call.
+ * The glyphs of a GLUT bitmap font are rendered once into a texture, each text line keeps its own quads
+ * and is only tessellated again when its text, position or color changes, and all visible lines share
+ * one vertex buffer. Without framebuffer objects the lines are drawn with glutBitmapCharacter instead.
+ *
+ */
+class HudText {
+private:
+    struct Line {
+        std::string text;
+        int x, y;
+        float color[4];
+        std::vector<float> vertices;    // x, y, s, t, r, g, b, a per vertex, two triangles per glyph
+    };
+
+    void *font;
+    int cellWidth;
+    int cellHeight;
+    int descent;                        // pixels of a cell under the baseline
+    unsigned char advances[128];
+    unsigned int atlas;                 // GL_TEXTURE_2D, 16 glyphs per row from the space
+    unsigned int vbo;
+    std::vector<Line> lines;
+    size_t lineCount;                   // lines shown, the others are kept for reuse
+    std::vector<float> vertices;        // visible lines back to back, as uploaded
+    bool dirty;                         // vertex buffer out of date
+    unsigned int tessellations;
+
+    void tessellate(Line &line);
+
+public:
+    HudText();
+
+    /**
+     * @brief Build the glyph atlas of a GLUT bitmap font. The OpenGL RC must be set.
+     *
+     * @param cellWidth, cellHeight glyph cell in pixels, the font's line height
+     * @return false if the atlas cannot be built, the text is then drawn per character
+     */
+    bool init(void *font, int cellWidth, int cellHeight);
+    void release();
+    bool isReady();
+
+    /**
+     * @brief Set a line of text, kept until changed
+     *
+     * @param index line slot, the slots are numbered from 0 without gaps
+     * @param x, y baseline origin in window pixels
+     */
+    void setLine(size_t index, const std::string &text, int x, int y, const float color[4]);
+
+    /**
+     * @brief Show only the first lines, the slots past them are hidden
+     *
+     */
+    void setLineCount(size_t count);
+
+    /**
+     * @brief Draw the shown lines with the current modelview and projection, set to window pixels
+     *
+     */
+    void draw();
+
+    /**
+     * @brief Lines tessellated so far
+     *
+     */
+    unsigned int getTessellationCount();
+};
+
+#endif
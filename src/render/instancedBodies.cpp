@@ -0,0 +1,132 @@
+#include "instancedBodies.hpp"
+#include "glResources.hpp"
+
+//===============================================================================================================
+// Constants Definition
+//===============================================================================================================
+static const size_t MAX_MATERIALS = 8;
+
+// Per-vertex lighting of GL_LIGHT0 as the fixed pipeline does it (ambient and diffuse, attenuated),
+// modulated by the texture layer of the body
+static const char *VERTEX_SHADER =
+    "#version 130\n"
+    "in vec3 vertex;\n"
+    "in vec3 normal;\n"
+    "in vec2 texCoord;\n"
+    "in vec4 body;\n"
+    "in vec2 style;\n"
+    "uniform vec4 materials[2 * 8];\n"
+    "out vec3 uv;\n"
+    "out vec4 color;\n"
+    "void main() {\n"
+    "    vec4 eyePos = gl_ModelViewMatrix * vec4(body.xyz + body.w * vertex, 1.0);\n"
+    "    vec3 n = normalize(gl_NormalMatrix * normal);\n"
+    "    int m = int(style.x);\n"
+    "    vec4 ka = materials[2 * m];\n"
+    "    vec4 kd = materials[2 * m + 1];\n"
+    "    vec3 toLight = gl_LightSource[0].position.xyz - eyePos.xyz;\n"
+    "    float d = length(toLight);\n"
+    "    float attenuation = 1.0 / (gl_LightSource[0].constantAttenuation + gl_LightSource[0].linearAttenuation * d +\n"
+    "                               gl_LightSource[0].quadraticAttenuation * d * d);\n"
+    "    color = gl_LightModel.ambient * ka + attenuation * (gl_LightSource[0].ambient * ka +\n"
+    "            gl_LightSource[0].diffuse * kd * max(dot(n, toLight / d), 0.0));\n"
+    "    color = vec4(clamp(color.rgb, 0.0, 1.0), kd.a);\n"
+    "    uv = vec3(texCoord, style.y);\n"
+    "    gl_Position = gl_ProjectionMatrix * eyePos;\n"
+    "}\n";
+
+static const char *FRAGMENT_SHADER =
+    "#version 130\n"
+    "uniform sampler2DArray textures;\n"
+    "in vec3 uv;\n"
+    "in vec4 color;\n"
+    "void main() {\n"
+    "    gl_FragColor = color * texture(textures, uv);\n"
+    "}\n";
+
+//===============================================================================================================
+// InstancedBodies Class
+//...............................................................................................................
+// Constructor
+//...............................................................................................................
+InstancedBodies::InstancedBodies() {
+    this->program = 0;
+    this->textures = 0;
+}
+
+//...............................................................................................................
+// Public Methods
+//...............................................................................................................
+bool InstancedBodies::init(const SphereLod &lod, const std::vector<std::string> &imagePaths, const float materials[][4][4], size_t materialCount) {
+#ifdef RENDER_SHADERS_SUPPORTED
+    if (!render::hasVersion(3, 3) || materialCount > MAX_MATERIALS)
+        return false;
+    if (!this->buildProgram(materials, materialCount)) {
+        this->release();
+        return false;
+    }
+    if (!this->spheres.init(lod)) {
+        this->release();
+        return false;
+    }
+    this->textures = render::loadTextureArray(imagePaths);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void InstancedBodies::release() {
+#ifdef RENDER_SHADERS_SUPPORTED
+    this->spheres.release();
+    if (this->textures != 0)
+        glDeleteTextures(1, &this->textures);
+    if (this->program != 0)
+        glDeleteProgram(this->program);
+    this->textures = this->program = 0;
+#endif
+}
+
+bool InstancedBodies::isReady() {
+    return this->spheres.isReady();
+}
+
+void InstancedBodies::draw(const float *x, const float *y, const float *z, const float *radius, const unsigned char *materials,
+                           const int *ids, const int *levels, size_t count) {
+#ifdef RENDER_SHADERS_SUPPORTED
+    if (!this->spheres.isReady() || count == 0)
+        return;
+    glUseProgram(this->program);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->textures);
+    this->spheres.draw(x, y, z, radius, materials, ids, levels, count, NULL);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glUseProgram(0);
+#endif
+}
+
+//...............................................................................................................
+// Private Methods
+//...............................................................................................................
+bool InstancedBodies::buildProgram(const float materials[][4][4], size_t materialCount) {
+#ifdef RENDER_SHADERS_SUPPORTED
+    this->program = render::buildProgram(VERTEX_SHADER, FRAGMENT_SHADER, render::ATTRIBUTE_NAMES, render::ATTRIBUTE_COUNT, "instanced body");
+    if (this->program == 0)
+        return false;
+
+    // Ambient and diffuse of each material, fixed for the lifetime of the program
+    float ambientDiffuse[2 * MAX_MATERIALS][4] = {};
+    for (size_t m = 0; m < materialCount; m++) {
+        for (int k = 0; k < 4; k++) {
+            ambientDiffuse[2 * m][k] = materials[m][0][k];
+            ambientDiffuse[2 * m + 1][k] = materials[m][1][k];
+        }
+    }
+    glUseProgram(this->program);
+    glUniform4fv(glGetUniformLocation(this->program, "materials"), 2 * MAX_MATERIALS, &ambientDiffuse[0][0]);
+    glUniform1i(glGetUniformLocation(this->program, "textures"), 0);
+    glUseProgram(0);
+    return true;
+#else
+    return false;
+#endif
+}
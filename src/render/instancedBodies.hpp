@@ -0,0 +1,51 @@
+#ifndef InstancedBodies_h
+#define InstancedBodies_h
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include "sphereInstances.hpp"
+#include "sphereLod.hpp"
+
+/**
+ * @brief Draws every visible body with one instanced call per sphere level of detail.
+ * Position, radius, material and texture layer of each body go in an instance buffer, all body textures
+ * are layers of one 2D texture array, and a small shader applies the material with the fixed-function
+ * lighting of GL_LIGHT0, so the frame looks the same as drawing the bodies one by one.
+ * Needs GL 3.3 and the sphere's GPU buffers.
+ *
+ */
+class InstancedBodies {
+private:
+    unsigned int program;
+    SphereInstances spheres;
+    unsigned int textures;          // GL_TEXTURE_2D_ARRAY, one layer per body id
+
+    bool buildProgram(const float materials[][4][4], size_t materialCount);
+
+public:
+    InstancedBodies();
+
+    /**
+     * @brief Create the program, the texture array and the instance arrays over the sphere levels.
+     * The OpenGL RC must be set.
+     *
+     * @param imagePaths texture of each body id, an image that cannot be read leaves its layer white
+     * @param materials {Ka, Kd, Ks, other} per BodyMaterial, only Ka and Kd are used
+     * @return false if the context or the sphere levels cannot draw instanced, the caller keeps drawing per body
+     */
+    bool init(const SphereLod &lod, const std::vector<std::string> &imagePaths, const float materials[][4][4], size_t materialCount);
+    void release();
+    bool isReady();
+
+    /**
+     * @brief Draw the listed bodies, one call per sphere level, with the current modelview and projection matrices
+     *
+     * @param ids body ids to draw, indexes of the store arrays and of the texture layers
+     * @param levels SphereLod level of each listed body, bodies under 0 are left out (points)
+     */
+    void draw(const float *x, const float *y, const float *z, const float *radius, const unsigned char *materials,
+              const int *ids, const int *levels, size_t count);
+};
+
+#endif
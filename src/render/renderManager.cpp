@@ -0,0 +1,182 @@
+#include "renderManager.hpp"
+#include "glResources.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+//===============================================================================================================
+// Constants Definition
+//===============================================================================================================
+static const size_t MAX_MATERIALS = 8;
+static const float GLOBAL_AMBIENT[3] = {0.2f, 0.2f, 0.2f};  // the fixed-function light model default
+
+static const char *VERTEX_SHADER =
+    "#version 330\n"
+    "in vec3 vertex;\n"
+    "in vec3 normal;\n"
+    "in vec2 texCoord;\n"
+    "in vec4 body;\n"
+    "in vec2 style;\n"
+    "uniform mat4 view;\n"
+    "uniform mat4 projection;\n"
+    "out vec3 position;\n"
+    "out vec3 surfaceNormal;\n"
+    "out vec3 uv;\n"
+    "flat out int material;\n"
+    "void main() {\n"
+    "    position = body.xyz + body.w * vertex;\n"
+    "    surfaceNormal = normal;\n"
+    "    uv = vec3(texCoord, style.y);\n"
+    "    material = int(style.x);\n"
+    "    gl_Position = projection * view * vec4(position, 1.0);\n"
+    "}\n";
+
+// Blinn-Phong from a point light, camera at the origin. Texture modulates ambient and diffuse,
+// specular is added after it
+static const char *FRAGMENT_SHADER =
+    "#version 330\n"
+    "uniform vec3 lightPos;\n"
+    "uniform vec3 lightAmbient;\n"
+    "uniform vec3 lightDiffuse;\n"
+    "uniform vec3 lightSpecular;\n"
+    "uniform vec3 lightAttenuation;\n"
+    "uniform vec3 globalAmbient;\n"
+    "uniform vec4 materials[3 * 8];\n"
+    "uniform sampler2DArray textures;\n"
+    "in vec3 position;\n"
+    "in vec3 surfaceNormal;\n"
+    "in vec3 uv;\n"
+    "flat in int material;\n"
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "    vec4 ka = materials[3 * material];\n"
+    "    vec4 kd = materials[3 * material + 1];\n"
+    "    vec4 ks = materials[3 * material + 2];\n"
+    "    vec3 n = normalize(surfaceNormal);\n"
+    "    vec3 toLight = lightPos - position;\n"
+    "    float d = length(toLight);\n"
+    "    vec3 l = toLight / d;\n"
+    "    float attenuation = 1.0 / (lightAttenuation.x + lightAttenuation.y * d + lightAttenuation.z * d * d);\n"
+    "    float diffuse = max(dot(n, l), 0.0);\n"
+    "    float specular = 0.0;\n"
+    "    if (diffuse > 0.0 && ks.w > 0.0)\n"
+    "        specular = pow(max(dot(n, normalize(l - normalize(position))), 0.0), ks.w);\n"
+    "    vec3 lit = globalAmbient * ka.rgb + attenuation * (lightAmbient * ka.rgb + lightDiffuse * kd.rgb * diffuse);\n"
+    "    vec3 color = min(lit, 1.0) * texture(textures, uv).rgb + attenuation * lightSpecular * ks.rgb * specular;\n"
+    "    fragColor = vec4(min(color, 1.0), kd.a);\n"
+    "}\n";
+
+//===============================================================================================================
+// RenderManager Class
+//...............................................................................................................
+// Constructor
+//...............................................................................................................
+RenderManager::RenderManager() {
+    this->program = 0;
+    this->textures = 0;
+    this->view = glm::mat4(1.0f);
+    this->projection = glm::mat4(1.0f);
+    this->lightAttenuation = glm::vec3(1, 0, 0);
+    this->viewLocation = this->projectionLocation = -1;
+    this->lightPosLocation = this->lightAmbientLocation = this->lightDiffuseLocation = -1;
+    this->lightSpecularLocation = this->lightAttenuationLocation = -1;
+}
+
+//...............................................................................................................
+// Public Methods
+//...............................................................................................................
+bool RenderManager::init(const SphereLod &lod, const std::vector<std::string> &imagePaths, const float materials[][4][4], size_t materialCount) {
+#ifdef RENDER_SHADERS_SUPPORTED
+    if (!render::hasVersion(3, 3) || materialCount > MAX_MATERIALS)
+        return false;
+    if (!this->spheres.init(lod))
+        return false;
+    this->program = render::buildProgram(VERTEX_SHADER, FRAGMENT_SHADER, render::ATTRIBUTE_NAMES, render::ATTRIBUTE_COUNT, "render manager");
+    if (this->program == 0) {
+        this->spheres.release();
+        return false;
+    }
+    this->viewLocation = glGetUniformLocation(this->program, "view");
+    this->projectionLocation = glGetUniformLocation(this->program, "projection");
+    this->lightPosLocation = glGetUniformLocation(this->program, "lightPos");
+    this->lightAmbientLocation = glGetUniformLocation(this->program, "lightAmbient");
+    this->lightDiffuseLocation = glGetUniformLocation(this->program, "lightDiffuse");
+    this->lightSpecularLocation = glGetUniformLocation(this->program, "lightSpecular");
+    this->lightAttenuationLocation = glGetUniformLocation(this->program, "lightAttenuation");
+
+    // Materials as {Ka, Kd, Ks with the shininess in w}, fixed for the lifetime of the program
+    float packed[3 * MAX_MATERIALS][4] = {};
+    for (size_t m = 0; m < materialCount; m++) {
+        for (int k = 0; k < 4; k++) {
+            packed[3 * m][k] = materials[m][0][k];
+            packed[3 * m + 1][k] = materials[m][1][k];
+            packed[3 * m + 2][k] = materials[m][2][k];
+        }
+        packed[3 * m + 2][3] = materials[m][3][0];
+    }
+    glUseProgram(this->program);
+    glUniform4fv(glGetUniformLocation(this->program, "materials"), 3 * MAX_MATERIALS, &packed[0][0]);
+    glUniform3fv(glGetUniformLocation(this->program, "globalAmbient"), 1, GLOBAL_AMBIENT);
+    glUniform1i(glGetUniformLocation(this->program, "textures"), 0);
+    glUseProgram(0);
+
+    this->textures = render::loadTextureArray(imagePaths);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void RenderManager::release() {
+#ifdef RENDER_SHADERS_SUPPORTED
+    this->spheres.release();
+    if (this->textures != 0)
+        glDeleteTextures(1, &this->textures);
+    if (this->program != 0)
+        glDeleteProgram(this->program);
+    this->textures = this->program = 0;
+#endif
+}
+
+bool RenderManager::isReady() {
+    return this->spheres.isReady();
+}
+
+void RenderManager::setView(glm::vec3 camera, glm::vec3 target, glm::vec3 up) {
+    this->camera = camera;
+    this->view = glm::lookAt(glm::vec3(0.0f), target - camera, up);
+}
+
+void RenderManager::setProjection(float fov, float aspect, float near, float far) {
+    if (near <= 0 || far <= near)
+        return;
+    this->projection = glm::perspective(glm::radians(fov), aspect, near, far);
+}
+
+void RenderManager::setLight(glm::vec3 pos, const float ambient[4], const float diffuse[4], const float specular[4], glm::vec3 attenuation) {
+    this->lightPos = pos;
+    this->lightAmbient = glm::vec3(ambient[0], ambient[1], ambient[2]);
+    this->lightDiffuse = glm::vec3(diffuse[0], diffuse[1], diffuse[2]);
+    this->lightSpecular = glm::vec3(specular[0], specular[1], specular[2]);
+    this->lightAttenuation = attenuation;
+}
+
+void RenderManager::render(const float *x, const float *y, const float *z, const float *radius, const unsigned char *materials,
+                           const int *ids, const int *levels, size_t count) {
+#ifdef RENDER_SHADERS_SUPPORTED
+    if (!this->spheres.isReady() || count == 0)
+        return;
+    glm::vec3 lightPos = this->lightPos - this->camera;
+    glUseProgram(this->program);
+    glUniformMatrix4fv(this->viewLocation, 1, GL_FALSE, glm::value_ptr(this->view));
+    glUniformMatrix4fv(this->projectionLocation, 1, GL_FALSE, glm::value_ptr(this->projection));
+    glUniform3fv(this->lightPosLocation, 1, glm::value_ptr(lightPos));
+    glUniform3fv(this->lightAmbientLocation, 1, glm::value_ptr(this->lightAmbient));
+    glUniform3fv(this->lightDiffuseLocation, 1, glm::value_ptr(this->lightDiffuse));
+    glUniform3fv(this->lightSpecularLocation, 1, glm::value_ptr(this->lightSpecular));
+    glUniform3fv(this->lightAttenuationLocation, 1, glm::value_ptr(this->lightAttenuation));
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->textures);
+    this->spheres.draw(x, y, z, radius, materials, ids, levels, count, glm::value_ptr(this->camera));
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glUseProgram(0);
+#endif
+}
@@ -0,0 +1,83 @@
+#ifndef RenderManager_h
+#define RenderManager_h
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "sphereInstances.hpp"
+#include "sphereLod.hpp"
+
+/**
+ * @brief Shader render backend, grown from the RenderManager of examples/dog. It keeps its own camera,
+ * projection and light instead of the fixed-function state, lights every pixel from a point light
+ * with attenuation, and draws the bodies instanced from the sphere levels and a texture array.
+ * Bodies and light are placed relative to the camera on the CPU, so the GPU never sees solar system
+ * sized coordinates. Needs GL 3.3 and the sphere's GPU buffers.
+ *
+ */
+class RenderManager {
+private:
+    unsigned int program;
+    SphereInstances spheres;
+    unsigned int textures;          // GL_TEXTURE_2D_ARRAY, one layer per body id
+
+    glm::vec3 camera;
+    glm::mat4 view;                 // camera orientation only
+    glm::mat4 projection;
+    glm::vec3 lightPos;
+    glm::vec3 lightAmbient;
+    glm::vec3 lightDiffuse;
+    glm::vec3 lightSpecular;
+    glm::vec3 lightAttenuation;     // constant, linear, quadratic
+
+    // Uniform locations
+    int viewLocation;
+    int projectionLocation;
+    int lightPosLocation;
+    int lightAmbientLocation;
+    int lightDiffuseLocation;
+    int lightSpecularLocation;
+    int lightAttenuationLocation;
+
+public:
+    RenderManager();
+
+    /**
+     * @brief Create the program, the texture array and the instance arrays over the sphere levels.
+     * The OpenGL RC must be set.
+     *
+     * @param imagePaths texture of each body id, an image that cannot be read leaves its layer white
+     * @param materials {Ka, Kd, Ks, other(shininess, ...)} per BodyMaterial
+     * @return false if the context or the sphere levels cannot use the backend
+     */
+    bool init(const SphereLod &lod, const std::vector<std::string> &imagePaths, const float materials[][4][4], size_t materialCount);
+    void release();
+    bool isReady();
+
+    void setView(glm::vec3 camera, glm::vec3 target, glm::vec3 up);
+
+    /**
+     * @brief Set the perspective projection, a clip range that is not positive keeps the previous one
+     *
+     * @param fov vertical field of view (degrees)
+     */
+    void setProjection(float fov, float aspect, float near, float far);
+
+    /**
+     * @brief Set the point light, its colors as {r, g, b, a} and its attenuation 1 / (c + l d + q d^2)
+     *
+     */
+    void setLight(glm::vec3 pos, const float ambient[4], const float diffuse[4], const float specular[4], glm::vec3 attenuation);
+
+    /**
+     * @brief Draw the listed bodies, one call per sphere level
+     *
+     * @param ids body ids to draw, indexes of the store arrays and of the texture layers
+     * @param levels SphereLod level of each listed body, bodies under 0 are left out (points)
+     */
+    void render(const float *x, const float *y, const float *z, const float *radius, const unsigned char *materials,
+                const int *ids, const int *levels, size_t count);
+};
+
+#endif
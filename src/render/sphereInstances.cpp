@@ -0,0 +1,111 @@
+#include "sphereInstances.hpp"
+#include "glResources.hpp"
+#include <algorithm>
+
+//===============================================================================================================
+// SphereInstances Class
+//...............................................................................................................
+// Constructor
+//...............................................................................................................
+SphereInstances::SphereInstances() {
+    this->instanceBuffer = 0;
+}
+
+//...............................................................................................................
+// Public Methods
+//...............................................................................................................
+bool SphereInstances::init(const SphereLod &lod) {
+#ifdef RENDER_SHADERS_SUPPORTED
+    for (size_t level = 0; level < lod.size(); level++) {
+        if (!lod.getLevel(level).hasBuffers())
+            return false;
+    }
+    glGenBuffers(1, &this->instanceBuffer);
+    for (size_t level = 0; level < lod.size(); level++) {
+        this->vaos.push_back(render::createInstancedSphere(lod.getLevel(level), this->instanceBuffer));
+        this->indexCounts.push_back(lod.getLevel(level).getIndexCount());
+    }
+    this->levelCounts.resize(lod.size());
+    this->levelStarts.resize(lod.size());
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SphereInstances::release() {
+#ifdef RENDER_SHADERS_SUPPORTED
+    if (!this->vaos.empty())
+        glDeleteVertexArrays((GLsizei)this->vaos.size(), this->vaos.data());
+    if (this->instanceBuffer != 0)
+        glDeleteBuffers(1, &this->instanceBuffer);
+    this->vaos.clear();
+    this->indexCounts.clear();
+    this->instanceBuffer = 0;
+#endif
+}
+
+bool SphereInstances::isReady() {
+    return !this->vaos.empty();
+}
+
+void SphereInstances::draw(const float *x, const float *y, const float *z, const float *radius, const unsigned char *materials,
+                           const int *ids, const int *levels, size_t count, const float origin[3]) {
+#ifdef RENDER_SHADERS_SUPPORTED
+    if (this->vaos.empty() || count == 0)
+        return;
+    static const float NO_ORIGIN[3] = {0, 0, 0};
+    if (origin == NULL)
+        origin = NO_ORIGIN;
+
+    // Counting sort by level, keeping the listed order inside each level
+    size_t levelCount = this->vaos.size();
+    std::fill(this->levelCounts.begin(), this->levelCounts.end(), 0);
+    for (size_t i = 0; i < count; i++) {
+        if (levels[i] >= 0 && (size_t)levels[i] < levelCount)
+            this->levelCounts[levels[i]]++;
+    }
+    size_t drawn = 0;
+    for (size_t level = 0; level < levelCount; level++) {
+        this->levelStarts[level] = drawn;
+        drawn += this->levelCounts[level];
+    }
+    if (drawn == 0)
+        return;
+
+    this->instances.resize(render::INSTANCE_FLOATS * drawn);
+    std::vector<size_t> &next = this->levelCounts;
+    std::copy(this->levelStarts.begin(), this->levelStarts.end(), next.begin());
+    for (size_t i = 0; i < count; i++) {
+        if (levels[i] < 0 || (size_t)levels[i] >= levelCount)
+            continue;
+        int id = ids[i];
+        float *instance = this->instances.data() + render::INSTANCE_FLOATS * next[levels[i]]++;
+        instance[0] = x[id] - origin[0];
+        instance[1] = y[id] - origin[1];
+        instance[2] = z[id] - origin[2];
+        instance[3] = radius[id];
+        instance[4] = materials[id];
+        instance[5] = id;
+    }
+
+    // A few bytes per body, respecified each frame so the driver never waits on the previous draw
+    glBindBuffer(GL_ARRAY_BUFFER, this->instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, this->instances.size() * sizeof(float), this->instances.data(), GL_STREAM_DRAW);
+
+    // Each level reads its own run of the buffer, the instance arrays of its vertex array start there
+    GLsizei stride = render::INSTANCE_FLOATS * sizeof(float);
+    for (size_t level = 0; level < levelCount; level++) {
+        size_t instanceCount = next[level] - this->levelStarts[level];
+        if (instanceCount == 0)
+            continue;
+        size_t offset = this->levelStarts[level] * stride;
+        glBindVertexArray(this->vaos[level]);
+        glVertexAttribPointer(render::ATTRIBUTE_BODY, 4, GL_FLOAT, GL_FALSE, stride, (void *)offset);
+        glVertexAttribPointer(render::ATTRIBUTE_STYLE, 2, GL_FLOAT, GL_FALSE, stride, (void *)(offset + 4 * sizeof(float)));
+        glDrawElementsInstanced(GL_TRIANGLES, this->indexCounts[level], GL_UNSIGNED_INT, (void *)0, (GLsizei)instanceCount);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+#endif
+}
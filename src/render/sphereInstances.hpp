@@ -0,0 +1,46 @@
+#ifndef SphereInstances_h
+#define SphereInstances_h
+
+#include <stddef.h>
+#include <vector>
+#include "sphereLod.hpp"
+
+/**
+ * @brief Instance buffer of the shader renderers over every level of a SphereLod.
+ * Bodies are packed grouped by level and each level is one instanced draw, so a frame costs at most
+ * one call per level whatever the number of bodies.
+ *
+ */
+class SphereInstances {
+private:
+    unsigned int instanceBuffer;
+    std::vector<unsigned int> vaos;         // one per level, all reading the instance buffer
+    std::vector<unsigned int> indexCounts;
+    std::vector<size_t> levelCounts;
+    std::vector<size_t> levelStarts;
+    std::vector<float> instances;           // x, y, z, radius, material, layer per drawn body
+
+public:
+    SphereInstances();
+
+    /**
+     * @brief Create the instance buffer and a vertex array per level. The OpenGL RC must be set.
+     *
+     * @return false if a level has no GPU buffers
+     */
+    bool init(const SphereLod &lod);
+    void release();
+    bool isReady();
+
+    /**
+     * @brief Draw the listed bodies with the bound program, one call per level in use
+     *
+     * @param ids body ids to draw, indexes of the store arrays and of the texture layers
+     * @param levels level of each listed body, bodies under 0 are skipped
+     * @param origin subtracted from the positions, NULL to keep them
+     */
+    void draw(const float *x, const float *y, const float *z, const float *radius, const unsigned char *materials,
+              const int *ids, const int *levels, size_t count, const float origin[3]);
+};
+
+#endif
@@ -0,0 +1,82 @@
+#include "sphereLod.hpp"
+#include <math.h>
+
+//===============================================================================================================
+// Constants Definition
+//===============================================================================================================
+struct LodLevel {
+    int sectors;
+    int stacks;
+    float minPixels;
+};
+
+// About 9k triangles for a body filling the window down to about 50 for one a few pixels wide
+static const LodLevel LOD_LEVELS[] = {
+    {96, 48, 256},
+    {48, 24, 64},
+    {24, 12, 16},
+    {12, 6,  4},
+    {6,  4,  1}
+};
+
+//===============================================================================================================
+// SphereLod Class
+//...............................................................................................................
+// Constructor
+//...............................................................................................................
+SphereLod::SphereLod() {
+    for (const LodLevel &level : LOD_LEVELS) {
+        this->levels.push_back(Sphere(1.0f, level.sectors, level.stacks));
+        this->minPixels.push_back(level.minPixels);
+    }
+}
+
+//...............................................................................................................
+// Public Methods
+//...............................................................................................................
+size_t SphereLod::size() const {
+    return this->levels.size();
+}
+
+Sphere &SphereLod::getLevel(size_t level) {
+    return this->levels[level];
+}
+
+const Sphere &SphereLod::getLevel(size_t level) const {
+    return this->levels[level];
+}
+
+int SphereLod::select(float pixels) const {
+    for (size_t level = 0; level < this->minPixels.size(); level++) {
+        if (pixels >= this->minPixels[level])
+            return (int)level;
+    }
+    return -1;
+}
+
+float SphereLod::screenRadius(float radius, float distance, float fov, int viewportHeight) {
+    // Inside or touching the body it fills the view
+    if (distance <= radius)
+        return (float)viewportHeight;
+    float angle = asinf(radius / distance);
+    return tanf(angle) / tanf(fov * (float)M_PI / 360) * viewportHeight / 2;
+}
+
+bool SphereLod::createBuffers() {
+    bool created = true;
+    for (Sphere &level : this->levels)
+        created = level.createBuffers() && created;
+    return created;
+}
+
+void SphereLod::releaseBuffers() {
+    for (Sphere &level : this->levels)
+        level.releaseBuffers();
+}
+
+unsigned int SphereLod::getBuildCount() const {
+    unsigned int count = 0;
+    for (const Sphere &level : this->levels)
+        count += level.getBuildCount();
+    return count;
+}
@@ -0,0 +1,52 @@
+#ifndef SphereLod_h
+#define SphereLod_h
+
+#include <stddef.h>
+#include <vector>
+#include "../Sphere.h"
+
+/**
+ * @brief Unit sphere tessellations from fine to coarse, built once, and the choice of one per body from
+ * the radius it covers on screen. Bodies under a pixel are drawn as points instead.
+ *
+ */
+class SphereLod {
+private:
+    std::vector<Sphere> levels;         // finest first
+    std::vector<float> minPixels;       // smallest screen radius drawn with each level
+
+public:
+    SphereLod();
+
+    size_t size() const;
+    Sphere &getLevel(size_t level);
+    const Sphere &getLevel(size_t level) const;
+
+    /**
+     * @brief Level for a screen radius in pixels
+     *
+     * @return the level, -1 if the body should be a point
+     */
+    int select(float pixels) const;
+
+    /**
+     * @brief Radius in pixels of a sphere seen from a distance, with a vertical field of view over a viewport height
+     *
+     */
+    static float screenRadius(float radius, float distance, float fov, int viewportHeight);
+
+    /**
+     * @brief Upload every level to GPU buffers, see Sphere::createBuffers()
+     *
+     */
+    bool createBuffers();
+    void releaseBuffers();
+
+    /**
+     * @brief Vertex generations of all levels so far
+     *
+     */
+    unsigned int getBuildCount() const;
+};
+
+#endif